@@ -0,0 +1,182 @@
+#ifndef BARNES_HUT_H
+#define BARNES_HUT_H
+
+#include "gravity.h"
+#include "thread_pool.h"
+#include <vector>
+#include <cmath>
+
+// --- BARNES-HUT ---
+// Октодерево хранится плоским массивом: у внутреннего узла 8 детей идут подряд,
+// тела листа — непрерывный диапазон в массиве order.
+
+const int OCTREE_MAX_DEPTH = 32;
+
+struct OctreeNode {
+    Vector3 center;    // геометрический центр куба
+    float halfSize;
+    Vector3 com;       // центр масс
+    float mass;
+    float openRadius;  // s + |com - center|, для критерия раскрытия
+    int firstChild;    // -1 у листа
+    int firstBody;
+    int bodyCount;
+};
+
+// Копия позиции и массы тела в порядке листьев — листья читают память подряд
+struct OctreePoint {
+    Vector3 position;
+    float mass;
+};
+
+struct Octree {
+    std::vector<OctreeNode> nodes;
+    std::vector<int> order;
+    std::vector<int> scratch;
+    std::vector<OctreePoint> points;
+};
+
+inline int OctantOf(Vector3 p, Vector3 center) {
+    return ((p.x >= center.x) ? 1 : 0) | ((p.y >= center.y) ? 2 : 0) | ((p.z >= center.z) ? 4 : 0);
+}
+
+inline void BuildOctreeNode(Octree& tree, const std::vector<Body>& bodies, int nodeIndex, int leafSize, int depth) {
+    OctreeNode node = tree.nodes[nodeIndex];
+
+    // Масса и центр масс узла
+    float mass = 0.0f;
+    Vector3 weighted = {0,0,0};
+    for (int k = 0; k < node.bodyCount; k++) {
+        const Body& b = bodies[tree.order[node.firstBody + k]];
+        mass += b.mass;
+        weighted = Vector3Add(weighted, Vector3Scale(b.position, b.mass));
+    }
+    node.mass = mass;
+    node.com = (mass > 0.0f) ? Vector3Scale(weighted, 1.0f/mass) : node.center;
+    node.openRadius = 2.0f*node.halfSize + Vector3Length(Vector3Subtract(node.com, node.center));
+    node.firstChild = -1;
+
+    if (node.bodyCount <= leafSize || depth >= OCTREE_MAX_DEPTH) {
+        tree.nodes[nodeIndex] = node;
+        return;
+    }
+
+    // Раскладываем тела по октантам (сортировка подсчётом)
+    int counts[8] = { 0 };
+    for (int k = 0; k < node.bodyCount; k++) {
+        int idx = tree.order[node.firstBody + k];
+        counts[OctantOf(bodies[idx].position, node.center)]++;
+    }
+    int offsets[8];
+    int running = 0;
+    for (int o = 0; o < 8; o++) { offsets[o] = running; running += counts[o]; }
+    for (int k = 0; k < node.bodyCount; k++) {
+        int idx = tree.order[node.firstBody + k];
+        tree.scratch[node.firstBody + offsets[OctantOf(bodies[idx].position, node.center)]++] = idx;
+    }
+    for (int k = 0; k < node.bodyCount; k++) tree.order[node.firstBody + k] = tree.scratch[node.firstBody + k];
+
+    node.firstChild = (int)tree.nodes.size();
+    tree.nodes[nodeIndex] = node;
+
+    float childHalf = node.halfSize * 0.5f;
+    int start = node.firstBody;
+    for (int o = 0; o < 8; o++) {
+        OctreeNode child = { 0 };
+        child.center = {
+            node.center.x + ((o & 1) ? childHalf : -childHalf),
+            node.center.y + ((o & 2) ? childHalf : -childHalf),
+            node.center.z + ((o & 4) ? childHalf : -childHalf)
+        };
+        child.halfSize = childHalf;
+        child.firstChild = -1;
+        child.firstBody = start;
+        child.bodyCount = counts[o];
+        start += counts[o];
+        tree.nodes.push_back(child);
+    }
+    for (int o = 0; o < 8; o++) {
+        if (counts[o] > 0) BuildOctreeNode(tree, bodies, node.firstChild + o, leafSize, depth + 1);
+    }
+}
+
+inline void BuildOctree(Octree& tree, const std::vector<Body>& bodies, int leafSize) {
+    tree.nodes.clear();
+    tree.order.resize(bodies.size());
+    tree.scratch.resize(bodies.size());
+    if (bodies.empty()) return;
+
+    Vector3 lo = bodies[0].position;
+    Vector3 hi = bodies[0].position;
+    for (size_t i = 0; i < bodies.size(); i++) {
+        tree.order[i] = (int)i;
+        lo = Vector3Min(lo, bodies[i].position);
+        hi = Vector3Max(hi, bodies[i].position);
+    }
+    Vector3 size = Vector3Subtract(hi, lo);
+    float halfSize = 0.5f*fmaxf(size.x, fmaxf(size.y, size.z)) * 1.001f + 1e-3f;
+
+    OctreeNode root = { 0 };
+    root.center = Vector3Scale(Vector3Add(lo, hi), 0.5f);
+    root.halfSize = halfSize;
+    root.firstChild = -1;
+    root.firstBody = 0;
+    root.bodyCount = (int)bodies.size();
+    tree.nodes.reserve(2*bodies.size()/(leafSize > 0 ? leafSize : 1) * 8 + 8);
+    tree.nodes.push_back(root);
+    BuildOctreeNode(tree, bodies, 0, (leafSize < 1) ? 1 : leafSize, 0);
+
+    tree.points.resize(bodies.size());
+    for (size_t k = 0; k < bodies.size(); k++) {
+        const Body& b = bodies[tree.order[k]];
+        tree.points[k] = { b.position, b.mass };
+    }
+}
+
+// Ускорение тела с номером self в порядке листьев: далёкие узлы — монополь, листья — точная сумма
+inline Vector3 OctreeAcceleration(const Octree& tree, int self, float theta) {
+    Vector3 pos = tree.points[self].position;
+    Vector3 acc = {0,0,0};
+    float invThetaSq = (theta > 0.0f) ? 1.0f/(theta*theta) : INFINITY;
+
+    // Глубина не больше OCTREE_MAX_DEPTH, на каждом уровне в стеке не больше 7 братьев
+    int stack[8*OCTREE_MAX_DEPTH + 8];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const OctreeNode& node = tree.nodes[stack[--top]];
+        if (node.mass <= 0.0f) continue;
+
+        Vector3 diff = Vector3Subtract(node.com, pos);
+        float distSq = Vector3LengthSqr(diff);
+
+        if (node.firstChild < 0) {
+            for (int j = node.firstBody; j < node.firstBody + node.bodyCount; j++) {
+                if (j == self) continue;
+                Vector3 d = Vector3Subtract(tree.points[j].position, pos);
+                float dSq = Vector3LengthSqr(d);
+                acc = Vector3Add(acc, Vector3Scale(d, G*tree.points[j].mass / (dSq*sqrtf(dSq))));
+            }
+        } else if (node.openRadius*node.openRadius*invThetaSq < distSq) {
+            acc = Vector3Add(acc, Vector3Scale(diff, G*node.mass / (distSq*sqrtf(distSq))));
+        } else {
+            for (int o = 7; o >= 0; o--) stack[top++] = node.firstChild + o;
+        }
+    }
+    return acc;
+}
+
+inline void ComputeAccelerationsBarnesHut(const std::vector<Body>& bodies, std::vector<Vector3>& acc, Octree& tree, float theta, int leafSize, ThreadPool* pool) {
+    acc.assign(bodies.size(), {0,0,0});
+    BuildOctree(tree, bodies, leafSize);
+    // Обходим тела в порядке листьев: соседние тела открывают одни и те же узлы
+    ParallelFor(pool, tree.order.size(), 64, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++) {
+            int i = tree.order[k];
+            if (bodies[i].isFixed) continue;
+            acc[i] = OctreeAcceleration(tree, (int)k, theta);
+        }
+    });
+}
+
+#endif
@@ -0,0 +1,1164 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "raylib.h"
+#include "physics.h"
+#include "scenes.h"
+#include "frame_budget.h"
+#include "collisions.h"
+#include "culling.h"
+#include "physics_thread.h"
+#include <vector>
+#include <map>
+#include <chrono>
+#include <cstring>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+// --- БЕНЧМАРКИ ---
+// Запуск: gravity --bench. Окно не создаётся, результаты идут в лог.
+
+inline double BenchNow() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Лучшее время из нескольких прогонов, в миллисекундах
+template <typename Fn>
+inline double BenchBestMs(int runs, Fn fn) {
+    double best = 1e30;
+    for (int r = 0; r < runs; r++) {
+        double start = BenchNow();
+        fn();
+        double elapsed = (BenchNow() - start)*1000.0;
+        if (elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+inline void BenchDirectKernels(int count) {
+    std::vector<Body> bodies;
+    LoadScene(bodies, SCENE_DISK, count - 1);
+    GravityWorkspace ws;
+    std::vector<Vector3> scalar;
+
+    double refMs = BenchBestMs(3, [&]() { ComputeAccelerationsReference(bodies, ws.reference); });
+    double scalarMs = BenchBestMs(3, [&]() {
+        PackBodies(bodies, ws.store);
+        scalar.assign(bodies.size(), {0,0,0});
+        for (size_t i = 0; i < bodies.size(); i++) if (!bodies[i].isFixed) scalar[i] = DirectAccelerationScalar(ws.store, i);
+    });
+    double simdMs = BenchBestMs(3, [&]() { ComputeAccelerationsDirectUntiled(bodies, ws.accelerations, ws.store, nullptr); });
+    std::vector<Vector3> pairwise;
+    double pairMs = BenchBestMs(3, [&]() { ComputeAccelerationsPairwise(bodies, pairwise, ws.store, ws.pairwise, nullptr); });
+
+    TraceLog(LOG_INFO, "BENCH: direct N=%d", (int)bodies.size());
+    TraceLog(LOG_INFO, "BENCH:   per-pair AoS  %8.2f ms", refMs);
+    TraceLog(LOG_INFO, "BENCH:   SoA scalar    %8.2f ms  x%.1f  err %.2e", scalarMs, refMs/scalarMs, MaxRelativeError(bodies, scalar, ws.reference));
+    TraceLog(LOG_INFO, "BENCH:   SoA %-9s %8.2f ms  x%.1f  err %.2e", DirectKernelName(), simdMs, refMs/simdMs, MaxRelativeError(bodies, ws.accelerations, ws.reference));
+    TraceLog(LOG_INFO, "BENCH:   pairwise      %8.2f ms  x%.1f  err %.2e", pairMs, refMs/pairMs, MaxRelativeError(bodies, pairwise, ws.reference));
+}
+
+// Все наборы команд, доступные на этой машине, на одном наборе тел.
+// Выбранный при запуске набор восстанавливается в конце.
+inline void BenchIsaDispatch(int count) {
+    std::vector<Body> bodies;
+    LoadScene(bodies, SCENE_DISK, count - 1);
+    GravityWorkspace ws;
+    ComputeAccelerationsReference(bodies, ws.reference);
+    std::vector<Vector3> pairwise;
+    GravityIsa active = ActiveIsa();
+
+    TraceLog(LOG_INFO, "BENCH: ISA dispatch N=%d, best %s", (int)bodies.size(), IsaName(DetectBestIsa()));
+    double scalarMs = 0.0;
+    for (int i = 0; i < ISA_COUNT; i++) {
+        GravityIsa isa = (GravityIsa)i;
+        if (!IsaSupported(isa)) continue;
+        ActiveIsaRef() = isa;
+        double directMs = BenchBestMs(3, [&]() { ComputeAccelerationsDirectUntiled(bodies, ws.accelerations, ws.store, nullptr); });
+        double pairMs = BenchBestMs(3, [&]() { ComputeAccelerationsPairwise(bodies, pairwise, ws.store, ws.pairwise, nullptr); });
+        if (isa == ISA_SCALAR) scalarMs = directMs;
+        TraceLog(LOG_INFO, "BENCH:   %-7s direct %8.2f ms  x%.1f  err %.2e   pairwise %8.2f ms  err %.2e", IsaName(isa),
+            directMs, scalarMs/directMs, MaxRelativeError(bodies, ws.accelerations, ws.reference),
+            pairMs, MaxRelativeError(bodies, pairwise, ws.reference));
+    }
+    ActiveIsaRef() = active;
+}
+
+inline bool SameBits(const std::vector<Vector3>& a, const std::vector<Vector3>& b) {
+    return (a.size() == b.size()) && (a.empty() || memcmp(a.data(), b.data(), a.size()*sizeof(Vector3)) == 0);
+}
+
+// Промахи последнего уровня кэша через perf_event; -1, если счётчики недоступны
+// (не Linux, нет PMU в виртуальной машине, запрет perf_event_paranoid)
+struct BenchMissCounter {
+    int fd = -1;
+};
+
+inline BenchMissCounter OpenMissCounter() {
+    BenchMissCounter counter;
+#if defined(__linux__)
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = 1;  // рабочие потоки пула тоже считаются
+    counter.fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    return counter;
+}
+
+inline void CloseMissCounter(BenchMissCounter& counter) {
+#if defined(__linux__)
+    if (counter.fd >= 0) close(counter.fd);
+#endif
+    counter.fd = -1;
+}
+
+template <typename Fn>
+inline long long BenchCountMisses(BenchMissCounter& counter, Fn fn) {
+#if defined(__linux__)
+    if (counter.fd >= 0) {
+        long long misses = 0;
+        ioctl(counter.fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter.fd, PERF_EVENT_IOC_ENABLE, 0);
+        fn();
+        ioctl(counter.fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter.fd, &misses, sizeof(misses)) == (ssize_t)sizeof(misses)) return misses;
+        return -1;
+    }
+#endif
+    fn();
+    return -1;
+}
+
+// Поток, который гоняет по памяти буфер больше L3, пока жив флаг
+struct BenchMemoryHog {
+    std::atomic<bool> run{false};
+    std::thread thread;
+};
+
+inline void StartMemoryHog(BenchMemoryHog& hog, size_t bytes) {
+    hog.run = true;
+    hog.thread = std::thread([&hog, bytes]() {
+        std::vector<float> buffer(bytes/sizeof(float), 1.0f);
+        volatile float sink = 0.0f;
+        while (hog.run.load(std::memory_order_relaxed)) {
+            float sum = 0.0f;
+            for (size_t i = 0; i < buffer.size(); i += 16) { buffer[i] += 1.0f; sum += buffer[i]; }
+            sink = sink + sum;
+        }
+    });
+}
+
+inline void StopMemoryHog(BenchMemoryHog& hog) {
+    hog.run = false;
+    if (hog.thread.joinable()) hog.thread.join();
+}
+
+// Построчная и блочная прямая сумма. Решатель по умолчанию — построчный;
+// блочный включается --tiled-direct. Строка "model" — только оценка чтения
+// источников в L1 (построчно N*N*16 байт, блочно по плитке на блок целей),
+// не измерение. Измеряется время, промахи LLC (если есть счётчики) и время
+// под нагрузкой на память от соседнего потока (если ядер больше одного).
+inline void BenchDirectTiling(ThreadPool* pool) {
+    CacheSizes cache = DetectCacheSizes();
+    GravityWorkspace ws;
+    TraceLog(LOG_INFO, "BENCH: tiled direct, L1d %d KB, L2 %d KB, L3 %d KB%s; tile %d targets x %d sources; %d threads",
+        (int)(cache.l1d/1024), (int)(cache.l2/1024), (int)(cache.l3/1024), cache.detected ? "" : " (defaults)",
+        (int)ws.tiling.targets, (int)ws.tiling.sources, ThreadPoolSize(pool));
+
+    BenchMissCounter counter = OpenMissCounter();
+    bool contention = std::thread::hardware_concurrency() > 1;
+    if (counter.fd < 0) TraceLog(LOG_INFO, "BENCH:   LLC miss counter unavailable");
+    if (!contention) TraceLog(LOG_INFO, "BENCH:   single core, contention run skipped");
+    size_t hogBytes = 4*(cache.l3 > cache.l2 ? cache.l3 : cache.l2);
+    if (hogBytes < ((size_t)64 << 20)) hogBytes = (size_t)64 << 20;
+
+    const int sizes[] = { 2048, 8192, 32768, 50000 };
+    std::vector<Body> bodies;
+    std::vector<Vector3> rows;
+    for (int n : sizes) {
+        LoadScene(bodies, SCENE_DISK, n - 1);
+        int runs = (n <= 8192) ? 3 : 1;
+        auto untiled = [&]() { ComputeAccelerationsDirectUntiled(bodies, rows, ws.store, pool); };
+        auto tiled = [&]() { ComputeAccelerationsDirect(bodies, ws.accelerations, ws.store, ws.tiling, ws.direct, pool); };
+        double rowsMs = BenchBestMs(runs, untiled);
+        double tiledMs = BenchBestMs(runs, tiled);
+        long long rowsMisses = BenchCountMisses(counter, untiled);
+        long long tiledMisses = BenchCountMisses(counter, tiled);
+        double rowsModel = (double)n*n*16.0;
+        double tiledModel = (double)n*16.0*((n + ws.tiling.targets - 1)/ws.tiling.targets);
+        TraceLog(LOG_INFO, "BENCH:   N=%-6d rows %8.1f ms  tiled %8.1f ms  x%.2f  model %7.1f -> %6.1f MB  %s", n,
+            rowsMs, tiledMs, rowsMs/tiledMs, rowsModel/1e6, tiledModel/1e6,
+            SameBits(rows, ws.accelerations) ? "bit-identical" : "MISMATCH");
+        if (rowsMisses >= 0 && tiledMisses >= 0) {
+            TraceLog(LOG_INFO, "BENCH:            LLC misses rows %lld (%.1f MB)  tiled %lld (%.1f MB)", rowsMisses, rowsMisses*64.0/1e6,
+                tiledMisses, tiledMisses*64.0/1e6);
+        }
+        if (contention) {
+            BenchMemoryHog hog;
+            StartMemoryHog(hog, hogBytes);
+            double rowsBusyMs = BenchBestMs(runs, untiled);
+            double tiledBusyMs = BenchBestMs(runs, tiled);
+            StopMemoryHog(hog);
+            TraceLog(LOG_INFO, "BENCH:            under %d MB stream: rows %8.1f ms  tiled %8.1f ms  x%.2f", (int)(hogBytes >> 20),
+                rowsBusyMs, tiledBusyMs, rowsBusyMs/tiledBusyMs);
+        }
+    }
+    CloseMissCounter(counter);
+}
+
+// Масштабирование по потокам и побитовое совпадение с однопоточным расчётом
+inline void BenchThreads(ThreadPool* pool, int count) {
+    std::vector<Body> bodies;
+    LoadScene(bodies, SCENE_DISK, count - 1);
+    GravityWorkspace ws;
+    std::vector<Vector3> serial;
+
+    GravitySettings settings = DefaultGravitySettings();
+    TraceLog(LOG_INFO, "BENCH: threads N=%d, pool of %d", (int)bodies.size(), ThreadPoolSize(pool));
+    for (int s = 0; s < SOLVER_COUNT; s++) {
+        settings.solver = (GravitySolver)s;
+        ws.pool = nullptr;
+        double serialMs = BenchBestMs(3, [&]() { ComputeAccelerations(bodies, serial, settings, ws); });
+        ws.pool = pool;
+        double parallelMs = BenchBestMs(3, [&]() { ComputeAccelerations(bodies, ws.accelerations, settings, ws); });
+        TraceLog(LOG_INFO, "BENCH:   %-7s 1 thread %8.2f ms, %d threads %8.2f ms  x%.1f  %s", GravitySolverName(settings.solver),
+            serialMs, ThreadPoolSize(pool), parallelMs, serialMs/parallelMs, SameBits(serial, ws.accelerations) ? "bit-identical" : "MISMATCH");
+    }
+}
+
+// Где быстрые решатели обгоняют прямую сумму. Прямая сумма и Barnes-Hut
+// на больших N не запускаются: время экстраполируется по N^2 и N log N.
+inline void BenchSolverCrossover(ThreadPool* pool) {
+    const int sizes[] = { 1000, 4000, 16000, 64000, 250000, 1000000 };
+    const int DIRECT_MAX = 16000;
+    const int BARNES_HUT_MAX = 250000;
+    GravitySettings settings = DefaultGravitySettings();
+    GravityWorkspace ws;
+    ws.pool = pool;
+    std::vector<Body> bodies;
+    double directMs = 0.0, directN = 0.0, bhMs = 0.0, bhN = 0.0;
+
+    TraceLog(LOG_INFO, "BENCH: crossover, theta %.2f, fmm order %d, %d threads (* = extrapolated)", settings.theta, settings.fmmOrder, ThreadPoolSize(pool));
+    for (int n : sizes) {
+        LoadScene(bodies, SCENE_DISK, n - 1);
+        int runs = (n <= 64000) ? 3 : 1;
+        bool directMeasured = (n <= DIRECT_MAX);
+        bool bhMeasured = (n <= BARNES_HUT_MAX);
+
+        settings.solver = SOLVER_DIRECT;
+        if (directMeasured) { directMs = BenchBestMs(runs, [&]() { ComputeAccelerations(bodies, ws.accelerations, settings, ws); }); directN = n; }
+        double direct = directMs*((double)n/directN)*((double)n/directN);
+
+        settings.solver = SOLVER_BARNES_HUT;
+        if (bhMeasured) { bhMs = BenchBestMs(runs, [&]() { ComputeAccelerations(bodies, ws.accelerations, settings, ws); }); bhN = n; }
+        double bh = bhMs*(n*log((double)n))/(bhN*log(bhN));
+
+        settings.solver = SOLVER_FMM;
+        double fmm = BenchBestMs(runs, [&]() { ComputeAccelerations(bodies, ws.accelerations, settings, ws); });
+
+        TraceLog(LOG_INFO, "BENCH:   N=%-8d direct %10.1f ms%s  bh %9.1f ms%s  fmm %9.1f ms  (%.0f ns/body)", n,
+            direct, directMeasured ? " " : "*", bh, bhMeasured ? " " : "*", fmm, fmm*1e6/n);
+    }
+}
+
+// Точность FMM по порядку разложения против прямой суммы
+inline void BenchFmmOrders(int count) {
+    std::vector<Body> bodies;
+    LoadScene(bodies, SCENE_DISK, count - 1);
+    GravityWorkspace ws;
+    GravitySettings settings = DefaultGravitySettings();
+    settings.solver = SOLVER_FMM;
+    ComputeAccelerationsReference(bodies, ws.reference);
+
+    TraceLog(LOG_INFO, "BENCH: fmm orders N=%d, theta %.2f", (int)bodies.size(), settings.theta);
+    for (int order = 2; order <= 8; order += 2) {
+        settings.fmmOrder = order;
+        double ms = BenchBestMs(3, [&]() { ComputeAccelerations(bodies, ws.accelerations, settings, ws); });
+        TraceLog(LOG_INFO, "BENCH:   p=%d %8.2f ms  err %.2e", order, ms, MaxRelativeError(bodies, ws.accelerations, ws.reference));
+    }
+}
+
+// Particle-mesh на однородном облаке: время по размеру сетки и ошибка
+// против прямой суммы (медианная — PM по построению сглаживает ближние пары)
+inline void BenchParticleMesh(ThreadPool* pool, int count) {
+    std::vector<Body> bodies;
+    LoadScene(bodies, SCENE_CLOUD, count);
+    GravityWorkspace ws;
+    ws.pool = pool;
+    GravitySettings settings = DefaultGravitySettings();
+    settings.solver = SOLVER_DIRECT;
+    double directMs = BenchBestMs(1, [&]() { ComputeAccelerations(bodies, ws.reference, settings, ws); });
+
+    TraceLog(LOG_INFO, "BENCH: particle-mesh, cloud N=%d, direct %.1f ms", (int)bodies.size(), directMs);
+    settings.solver = SOLVER_PM;
+    for (int b = 0; b < 2; b++) {
+        settings.pmBoundary = (PmBoundary)b;
+        for (int grid = 32; grid <= 128; grid *= 2) {
+            settings.pmGrid = grid;
+            ComputeAccelerations(bodies, ws.accelerations, settings, ws);  // Грин строится один раз
+            double ms = BenchBestMs(3, [&]() { ComputeAccelerations(bodies, ws.accelerations, settings, ws); });
+            std::vector<float> errors;
+            for (size_t i = 0; i < bodies.size(); i++) {
+                float refLen = Vector3Length(ws.reference[i]);
+                if (refLen > 0.0f) errors.push_back(Vector3Length(Vector3Subtract(ws.accelerations[i], ws.reference[i]))/refLen);
+            }
+            std::sort(errors.begin(), errors.end());
+            TraceLog(LOG_INFO, "BENCH:   %-8s %3d^3 %8.1f ms  x%.1f  median err %.2e", PmBoundaryName(settings.pmBoundary), grid,
+                ms, directMs/ms, errors.empty() ? 0.0f : errors[errors.size()/2]);
+        }
+    }
+}
+
+// Ускорения в double по точным позициям — эталон для далёких сцен
+inline void ComputeAccelerationsDouble(const std::vector<Body>& bodies, const std::vector<double>& pos, std::vector<Vector3>& acc) {
+    acc.assign(bodies.size(), {0,0,0});
+    for (size_t i = 0; i < bodies.size(); i++) {
+        if (bodies[i].isFixed) continue;
+        double ax = 0.0, ay = 0.0, az = 0.0;
+        for (size_t j = 0; j < bodies.size(); j++) {
+            double dx = pos[3*j] - pos[3*i], dy = pos[3*j + 1] - pos[3*i + 1], dz = pos[3*j + 2] - pos[3*i + 2];
+            double distSq = dx*dx + dy*dy + dz*dz;
+            if (distSq <= 0.0) continue;
+            double scale = bodies[j].mass/(distSq*sqrt(distSq));
+            ax += dx*scale; ay += dy*scale; az += dz*scale;
+        }
+        acc[i] = { (float)(G*ax), (float)(G*ay), (float)(G*az) };
+    }
+}
+
+// Медиана относительной ошибки (максимум даёт MaxRelativeError)
+inline float MedianRelativeError(const std::vector<Body>& bodies, const std::vector<Vector3>& acc, const std::vector<Vector3>& ref) {
+    std::vector<float> errors;
+    for (size_t i = 0; i < bodies.size(); i++) {
+        float refLen = Vector3Length(ref[i]);
+        if (bodies[i].isFixed || refLen <= 0.0f) continue;
+        errors.push_back(Vector3Length(Vector3Subtract(acc[i], ref[i]))/refLen);
+    }
+    if (errors.empty()) return 0.0f;
+    std::nth_element(errors.begin(), errors.begin() + errors.size()/2, errors.end());
+    return errors[errors.size()/2];
+}
+
+// Точность rsqrt + шаг Ньютона против прежнего пути (sqrt, нормализация,
+// деление на массу) — обе относительно суммы в double
+inline void BenchForcePrecision(int count) {
+    std::vector<Body> bodies;
+    LoadScene(bodies, SCENE_DISK, count - 1);
+    GravityWorkspace ws;
+    std::vector<double> pos(3*bodies.size());
+    for (size_t i = 0; i < bodies.size(); i++) BodyOffset(bodies[i], &pos[3*i]);
+    std::vector<Vector3> exact, pairwise;
+    ComputeAccelerationsDouble(bodies, pos, exact);
+    ComputeAccelerationsReference(bodies, ws.reference);
+    GravityIsa active = ActiveIsa();
+
+    TraceLog(LOG_INFO, "BENCH: force precision N=%d, relative error vs double", (int)bodies.size());
+    TraceLog(LOG_INFO, "BENCH:   sqrt+normalize     max %.2e  median %.2e", MaxRelativeError(bodies, ws.reference, exact), MedianRelativeError(bodies, ws.reference, exact));
+    for (int i = 0; i < ISA_COUNT; i++) {
+        GravityIsa isa = (GravityIsa)i;
+        if (!IsaSupported(isa)) continue;
+        ActiveIsaRef() = isa;
+        ComputeAccelerationsDirectUntiled(bodies, ws.accelerations, ws.store, nullptr);
+        ComputeAccelerationsPairwise(bodies, pairwise, ws.store, ws.pairwise, nullptr);
+        TraceLog(LOG_INFO, "BENCH:   %-7s direct     max %.2e  median %.2e   pairwise max %.2e  median %.2e", IsaName(isa),
+            MaxRelativeError(bodies, ws.accelerations, exact), MedianRelativeError(bodies, ws.accelerations, exact),
+            MaxRelativeError(bodies, pairwise, exact), MedianRelativeError(bodies, pairwise, exact));
+    }
+    ActiveIsaRef() = active;
+}
+
+// Сцена, унесённая далеко от начала координат: точность сил и дрейфа
+// для голых float-позиций и для double-float позиций с плавающим началом
+inline void BenchFloatingOrigin(int count) {
+    std::vector<Body> bodies;
+    LoadScene(bodies, SCENE_DISK, count - 1);
+    GravityWorkspace ws;
+    std::vector<Vector3> exact;
+    std::vector<double> pos(3*bodies.size());
+
+    TraceLog(LOG_INFO, "BENCH: floating origin, disk N=%d", (int)bodies.size());
+    const double offsets[] = { 0.0, 1e4, 1e5, 1e6 };
+    for (double offset : offsets) {
+        for (size_t i = 0; i < bodies.size(); i++) {
+            pos[3*i] = bodies[i].position.x + offset;
+            pos[3*i + 1] = bodies[i].position.y;
+            pos[3*i + 2] = bodies[i].position.z + offset;
+        }
+        ComputeAccelerationsDouble(bodies, pos, exact);
+
+        // Как раньше: float-позиции прямо в мировых координатах
+        std::vector<Body> plain = bodies;
+        for (size_t i = 0; i < plain.size(); i++) {
+            plain[i].position = { (float)pos[3*i], (float)pos[3*i + 1], (float)pos[3*i + 2] };
+            plain[i].positionLo = { 0, 0, 0 };
+        }
+        ComputeAccelerationsDirectUntiled(plain, ws.accelerations, ws.store, nullptr);
+        float plainErr = MaxRelativeError(plain, ws.accelerations, exact);
+
+        // Double-float позиции; начало координат перенесено к сцене
+        std::vector<Body> split = bodies;
+        for (size_t i = 0; i < split.size(); i++) SetBodyOffset(split[i], pos[3*i], pos[3*i + 1], pos[3*i + 2]);
+        ComputeAccelerationsDirectUntiled(split, ws.accelerations, ws.store, nullptr);
+        float splitErr = MaxRelativeError(split, ws.accelerations, exact);
+        WorldOrigin origin = { 0.0, 0.0, 0.0 };
+        RebaseOrigin(split, origin, { (float)offset, 0.0f, (float)offset }, 4.0f);
+        ComputeAccelerationsDirectUntiled(split, ws.accelerations, ws.store, nullptr);
+        float rebasedErr = MaxRelativeError(split, ws.accelerations, exact);
+
+        // Дрейф: 100000 шагов с постоянной скоростью
+        const int STEPS = 100000;
+        const float DT = 0.0005f;
+        Body plainBody = { { (float)offset, 0, 0 }, { 37.3f, 0, 0 }, 1.0f, 1.0f, WHITE, false };
+        Body splitBody = plainBody;
+        for (int s = 0; s < STEPS; s++) {
+            plainBody.position.x += plainBody.velocity.x*DT;
+            DriftBody(splitBody, DT);
+        }
+        double expected = offset + (double)37.3f*(double)DT*STEPS;
+        double splitPos[3];
+        BodyOffset(splitBody, splitPos);
+
+        TraceLog(LOG_INFO, "BENCH:   offset %8.0e  force err: float %.2e, double-float %.2e, rebased %.2e  drift err: float %.2e, double-float %.2e",
+            offset, plainErr, splitErr, rebasedErr, fabs(plainBody.position.x - expected), fabs(splitPos[0] - expected));
+    }
+}
+
+// Полная энергия в double (пары закреплённых тел дают константу и пропускаются)
+inline double TotalEnergy(const std::vector<Body>& bodies) {
+    std::vector<double> pos(3*bodies.size());
+    for (size_t i = 0; i < bodies.size(); i++) BodyOffset(bodies[i], &pos[3*i]);
+    double kinetic = 0.0, potential = 0.0;
+    for (size_t i = 0; i < bodies.size(); i++) {
+        const Vector3& v = bodies[i].velocity;
+        if (!bodies[i].isFixed) kinetic += 0.5*bodies[i].mass*((double)v.x*v.x + (double)v.y*v.y + (double)v.z*v.z);
+        for (size_t j = i + 1; j < bodies.size(); j++) {
+            if (bodies[i].isFixed && bodies[j].isFixed) continue;
+            double dx = pos[3*j] - pos[3*i], dy = pos[3*j + 1] - pos[3*i + 1], dz = pos[3*j + 2] - pos[3*i + 2];
+            potential -= (double)G*bodies[i].mass*bodies[j].mass/sqrt(dx*dx + dy*dy + dz*dz);
+        }
+    }
+    return kinetic + potential;
+}
+
+// Положение на кеплеровой орбите через time после апоцентра (+x, движение к +z)
+inline Vector3 KeplerPosition(double semiMajor, double eccentricity, double gm, double time) {
+    double n = sqrt(gm/(semiMajor*semiMajor*semiMajor));
+    double mean = PI + n*time;
+    double ecc = mean;
+    for (int k = 0; k < 30; k++) ecc -= (ecc - eccentricity*sin(ecc) - mean)/(1.0 - eccentricity*cos(ecc));
+    double xp = semiMajor*(cos(ecc) - eccentricity);
+    double yp = semiMajor*sqrt(1.0 - eccentricity*eccentricity)*sin(ecc);
+    return { (float)-xp, 0.0f, (float)-yp };
+}
+
+// Эйлер на базовом шаге против leapfrog на шагах крупнее.
+// Кеплерова орбита e = 0.5: наибольшее отклонение от точного решения за
+// 5 оборотов (в долях полуоси) и размах ошибки энергии. Планетная система:
+// отклонение от эталона (leapfrog с шагом в 4 раза мельче базового) и
+// ошибка полной энергии. Диск сюда не годится: тесные сближения без
+// смягчения делают его хаотичным, и отклонение ничего не говорит о схеме.
+inline void BenchIntegrators(ThreadPool* pool) {
+    const float STAR_MASS = 5000.0f, SEMI_MAJOR = 40.0f, ECCENTRICITY = 0.5f;
+    const int ORBITS = 5;
+    double gm = (double)G*STAR_MASS;
+    double period = 2.0*PI*sqrt((double)SEMI_MAJOR*SEMI_MAJOR*SEMI_MAJOR/gm);
+    float apoapsis = SEMI_MAJOR*(1.0f + ECCENTRICITY);
+    float apoSpeed = (float)sqrt(gm/SEMI_MAJOR*(1.0 - ECCENTRICITY)/(1.0 + ECCENTRICITY));
+
+    struct Case { Integrator integrator; int stride; };
+    const Case cases[] = {
+        { INTEGRATOR_EULER, 1 }, { INTEGRATOR_LEAPFROG, 1 }, { INTEGRATOR_LEAPFROG, 2 },
+        { INTEGRATOR_LEAPFROG, 4 }, { INTEGRATOR_LEAPFROG, 8 }, { INTEGRATOR_LEAPFROG, 16 },
+        { INTEGRATOR_ADAPTIVE, 8 }, { INTEGRATOR_HERMITE, 8 }, { INTEGRATOR_HERMITE, 16 }, { INTEGRATOR_WISDOM_HOLMAN, 16 }
+    };
+    GravitySettings settings = DefaultGravitySettings();
+    GravityWorkspace ws;
+
+    TraceLog(LOG_INFO, "BENCH: integrators, Kepler e=%.1f a=%.0f (period %.3f), %d orbits", ECCENTRICITY, SEMI_MAJOR, period, ORBITS);
+    for (const Case& c : cases) {
+        std::vector<Body> bodies = {
+            { {0,0,0}, {0,0,0}, STAR_MASS, 10.0f, GOLD, true },
+            { {apoapsis,0,0}, {0,0,apoSpeed}, 1e-3f, 1.0f, WHITE, false }
+        };
+        settings.integrator = c.integrator;
+        InvalidateAccelerationCache(ws);
+        float dt = BASE_DT*c.stride;
+        int steps = (int)llround(ORBITS*period/dt);
+        double e0 = TotalEnergy(bodies), energyErr = 0.0, posErr = 0.0;
+        long long evals = 0;
+        for (int s = 0; s < steps; s++) {
+            StepPhysics(bodies, dt, settings, ws);
+            const BlockStats* blocks = IntegratorBlockStats(ws, c.integrator);
+            evals += blocks ? blocks->blocks : 1;
+            if ((s + 1) % 16 != 0) continue;
+            Vector3 exact = KeplerPosition(SEMI_MAJOR, ECCENTRICITY, gm, (s + 1)*(double)dt);
+            posErr = fmax(posErr, Vector3Distance(bodies[1].position, exact)/SEMI_MAJOR);
+            energyErr = fmax(energyErr, fabs(TotalEnergy(bodies) - e0)/fabs(e0));
+        }
+        TraceLog(LOG_INFO, "BENCH:   %-8s x%-2d dt %.4f  %5.0f evals/unit  max pos err %.2e  energy err %.2e",
+            IntegratorName(c.integrator), c.stride, dt, evals/(steps*(double)dt), posErr, energyErr);
+    }
+
+    // Планетная система: 6 лёгких планет на круговых орбитах 30..230, без тесных сближений
+    const int PLANETS = 6;
+    const float DURATION = 5.0f;
+    std::vector<Body> start = { { {0,0,0}, {0,0,0}, STAR_MASS, 10.0f, GOLD, true } };
+    for (int k = 0; k < PLANETS; k++) {
+        float r = 30.0f*powf(1.5f, (float)k), angle = 2.4f*k, speed = sqrtf(G*STAR_MASS/r);
+        start.push_back({ { r*cosf(angle), 0.0f, r*sinf(angle) }, { -speed*sinf(angle), 0.0f, speed*cosf(angle) }, 0.5f, 1.0f, WHITE, false });
+    }
+    std::vector<Body> exact = start;
+    ws.pool = pool;
+    settings.integrator = INTEGRATOR_LEAPFROG;
+    InvalidateAccelerationCache(ws);
+    for (int s = 0; s < (int)llround(4*DURATION/BASE_DT); s++) StepPhysics(exact, 0.25f*BASE_DT, settings, ws);
+
+    TraceLog(LOG_INFO, "BENCH: integrators, %d planets for %.0f time units against leapfrog at dt/4", PLANETS, DURATION);
+    for (const Case& c : cases) {
+        std::vector<Body> bodies = start;
+        settings.integrator = c.integrator;
+        InvalidateAccelerationCache(ws);
+        float dt = BASE_DT*c.stride;
+        int steps = (int)llround(DURATION/dt);
+        double e0 = TotalEnergy(bodies), energyErr = 0.0;
+        long long evals = 0;
+        for (int s = 0; s < steps; s++) {
+            StepPhysics(bodies, dt, settings, ws);
+            const BlockStats* blocks = IntegratorBlockStats(ws, c.integrator);
+            evals += blocks ? blocks->blocks : 1;
+            if (s % 16 == 0) energyErr = fmax(energyErr, fabs(TotalEnergy(bodies) - e0)/fabs(e0));
+        }
+        float posErr = 0.0f;
+        for (size_t i = 1; i < bodies.size(); i++) posErr = fmaxf(posErr, Vector3Distance(bodies[i].position, exact[i].position)/Vector3Length(exact[i].position));
+        TraceLog(LOG_INFO, "BENCH:   %-8s x%-2d dt %.4f  %6lld evals  max pos err %.2e  energy err %.2e",
+            IntegratorName(c.integrator), c.stride, dt, evals, posErr, energyErr);
+    }
+}
+
+// Сцена moons: тесные пары среди медленного диска. Блочные шаги против
+// той же схемы с общим шагом (самый мелкий на всех) и против leapfrog
+inline void BenchBlockSteps(ThreadPool* pool, int count) {
+    const int OUTER_STEPS = 10;
+    std::vector<Body> start;
+    LoadScene(start, SCENE_MOONS, count);
+    GravitySettings settings = DefaultGravitySettings();
+    GravityWorkspace ws;
+    ws.pool = pool;
+    double e0 = TotalEnergy(start);
+
+    TraceLog(LOG_INFO, "BENCH: block steps, moons scene with %d bodies, %d outer steps", (int)start.size(), OUTER_STEPS);
+    const Integrator integrators[] = { INTEGRATOR_ADAPTIVE, INTEGRATOR_HERMITE };
+    for (Integrator integrator : integrators) {
+        settings.integrator = integrator;
+        float outer = BASE_DT*IntegratorStride(integrator);
+        BlockScheduler& sched = (integrator == INTEGRATOR_HERMITE) ? ws.hermite.blocks : ws.adaptive.blocks;
+        std::vector<Body> shared;
+        double sharedMs = 0.0;
+        for (int mode = 1; mode >= 0; mode--) {
+            std::vector<Body> bodies = start;
+            InvalidateAccelerationCache(ws);
+            sched.sharedStep = mode != 0;
+            BlockStats total = { 0, 0, 0, 0 };
+            double t0 = BenchNow();
+            for (int s = 0; s < OUTER_STEPS; s++) {
+                StepPhysics(bodies, outer, settings, ws);
+                total.blocks += sched.stats.blocks;
+                total.updates += sched.stats.updates;
+                total.bodies = sched.stats.bodies;
+                total.deepestLevel = std::max(total.deepestLevel, sched.stats.deepestLevel);
+            }
+            double ms = (BenchNow() - t0)*1000.0;
+            double energyErr = fabs(TotalEnergy(bodies) - e0)/fabs(e0);
+            if (mode) {
+                sharedMs = ms;
+                shared = bodies;
+                TraceLog(LOG_INFO, "BENCH:   %-8s shared %8.1f ms  %5d blocks  %8lld updates  min dt/%-4d  energy err %.2e",
+                    IntegratorName(integrator), ms, total.blocks, total.updates, 1 << total.deepestLevel, energyErr);
+            } else {
+                // Блочные шаги против общего: насколько разошлись траектории
+                float diff = 0.0f;
+                for (size_t i = 0; i < bodies.size(); i++) diff = fmaxf(diff, Vector3Distance(bodies[i].position, shared[i].position));
+                TraceLog(LOG_INFO, "BENCH:   %-8s block  %8.1f ms  %5d blocks  %8lld updates  min dt/%-4d  energy err %.2e  active %.1f%%  x%.1f, max diff %.1e",
+                    IntegratorName(integrator), ms, total.blocks, total.updates, 1 << total.deepestLevel, energyErr,
+                    ActiveFraction(total)*100.0f, sharedMs/ms, diff);
+            }
+        }
+        sched.sharedStep = false;
+    }
+
+    std::vector<Body> bodies = start;
+    settings.integrator = INTEGRATOR_LEAPFROG;
+    InvalidateAccelerationCache(ws);
+    float dt = BASE_DT*LEAPFROG_STRIDE;
+    int steps = OUTER_STEPS*HERMITE_STRIDE/LEAPFROG_STRIDE;
+    double t0 = BenchNow();
+    for (int s = 0; s < steps; s++) StepPhysics(bodies, dt, settings, ws);
+    double ms = (BenchNow() - t0)*1000.0;
+    TraceLog(LOG_INFO, "BENCH:   leapfrog        %8.1f ms  %5d steps   %8lld updates               energy err %.2e",
+        ms, steps, (long long)steps*(long long)bodies.size(), fabs(TotalEnergy(bodies) - e0)/fabs(e0));
+}
+
+// Планетная система: Wisdom-Holman с шагом в долю кратчайшего периода против
+// leapfrog. Эталон — Wisdom-Holman с шагом в 32 раза мельче.
+inline void BenchWisdomHolman(ThreadPool* pool) {
+    const float STAR_MASS = 5000.0f;
+    const int PLANETS = 6;
+    const int ORBITS = 30;  // орбит внутренней планеты
+    std::vector<Body> start = { { {0,0,0}, {0,0,0}, STAR_MASS, 10.0f, GOLD, true } };
+    for (int k = 0; k < PLANETS; k++) {
+        float r = 30.0f*powf(1.5f, (float)k), angle = 2.4f*k, speed = sqrtf(G*STAR_MASS/r);
+        start.push_back({ { r*cosf(angle), 0.0f, r*sinf(angle) }, { -speed*sinf(angle), 0.0f, speed*cosf(angle) }, 0.5f, 1.0f, WHITE, false });
+    }
+    GravitySettings settings = DefaultGravitySettings();
+    GravityWorkspace ws;
+    ws.pool = pool;
+    InitWisdomHolman(start, ws.wh);
+    double period = ws.wh.maxStep*WH_STEPS_PER_ORBIT;
+    double duration = ORBITS*period;
+    double e0 = TotalEnergy(start);
+
+    // Прогон схемы шагами dt; возвращает время в мс, число вычислений сил — в evals
+    auto run = [&](std::vector<Body>& bodies, Integrator integrator, double dt, long long* evals) {
+        settings.integrator = integrator;
+        InvalidateAccelerationCache(ws);
+        int steps = (int)llround(duration/dt);
+        double t0 = BenchNow();
+        for (int s = 0; s < steps; s++) StepPhysics(bodies, (float)dt, settings, ws);
+        *evals = steps;
+        return (BenchNow() - t0)*1000.0;
+    };
+    std::vector<Body> exact = start;
+    long long evals = 0;
+    run(exact, INTEGRATOR_WISDOM_HOLMAN, period/(32*WH_STEPS_PER_ORBIT), &evals);
+
+    TraceLog(LOG_INFO, "BENCH: wisdom-holman, %d planets for %d inner orbits (period %.3f)", PLANETS, ORBITS, period);
+    struct Case { Integrator integrator; double dt; };
+    const Case cases[] = {
+        { INTEGRATOR_LEAPFROG, BASE_DT }, { INTEGRATOR_LEAPFROG, BASE_DT*LEAPFROG_STRIDE },
+        { INTEGRATOR_LEAPFROG, period/WH_STEPS_PER_ORBIT },
+        { INTEGRATOR_WISDOM_HOLMAN, period/WH_STEPS_PER_ORBIT }, { INTEGRATOR_WISDOM_HOLMAN, period/(2*WH_STEPS_PER_ORBIT) }
+    };
+    for (const Case& c : cases) {
+        std::vector<Body> bodies = start;
+        double ms = run(bodies, c.integrator, c.dt, &evals);
+        float posErr = 0.0f;
+        for (size_t i = 1; i < bodies.size(); i++) posErr = fmaxf(posErr, Vector3Distance(bodies[i].position, exact[i].position)/Vector3Length(exact[i].position));
+        TraceLog(LOG_INFO, "BENCH:   %-8s dt %.4f  %6lld evals  %7.1f ms  max pos err %.2e  energy err %.2e",
+            IntegratorName(c.integrator), c.dt, evals, ms, posErr, fabs(TotalEnergy(bodies) - e0)/fabs(e0));
+    }
+}
+
+// Leapfrog с выделением тесных пар и без: moons (шесть долгоживущих пар) и
+// диск (случайные сближения). Без пар тот же уровень ошибки требует мелкого шага.
+inline void BenchEncounters(ThreadPool* pool, int count) {
+    const float DURATION = 0.5f;
+    GravityWorkspace ws;
+    ws.pool = pool;
+    const SceneId scenes[] = { SCENE_MOONS, SCENE_DISK };
+    for (SceneId scene : scenes) {
+        std::vector<Body> start;
+        LoadScene(start, scene, count);
+        double e0 = TotalEnergy(start);
+        TraceLog(LOG_INFO, "BENCH: encounters, %s scene with %d bodies for %.1f time units", SceneName(scene), (int)start.size(), DURATION);
+        struct Case { bool regularize; int stride; };
+        const Case cases[] = { { true, LEAPFROG_STRIDE }, { false, LEAPFROG_STRIDE }, { false, 1 } };
+        for (const Case& c : cases) {
+            GravitySettings settings = DefaultGravitySettings();
+            settings.regularize = c.regularize;
+            InvalidateAccelerationCache(ws);
+            std::vector<Body> bodies = start;
+            float dt = BASE_DT*c.stride;
+            int steps = (int)llround(DURATION/dt), maxPairs = 0;
+            double energyErr = 0.0;
+            double t0 = BenchNow();
+            for (int s = 0; s < steps; s++) {
+                StepPhysics(bodies, dt, settings, ws);
+                maxPairs = std::max(maxPairs, (int)ws.encounters.pairs.size());
+                if (s % 25 == 0) energyErr = fmax(energyErr, fabs(TotalEnergy(bodies) - e0)/fabs(e0));
+            }
+            double ms = (BenchNow() - t0)*1000.0;
+            TraceLog(LOG_INFO, "BENCH:   %-10s dt %.4f  %8.1f ms  pairs up to %2d  max energy err %.2e",
+                c.regularize ? "regularize" : "plain", dt, ms, maxPairs, energyErr);
+        }
+    }
+}
+
+// Ход регулятора за прогон: последнее решение и качание. Разворот — рычаг
+// сдвинулся в сторону, обратную своему прошлому сдвигу; во второй половине
+// прогона регулятор должен стоять, а разворотов там быть не должно вовсе.
+struct GovernorTrace {
+    int lastChange = 0;
+    int lateChanges = 0;
+    int lateReversals = 0;
+    int lastMove[3] = { 0, 0, 0 };  // подшаги, сетка, темп: -1, 0, +1
+};
+
+inline void TraceGovernorChange(GovernorTrace& t, const FrameGovernor& before, const FrameGovernor& after, int frame, int frames) {
+    int move[3] = {
+        (after.substeps > before.substeps) - (after.substeps < before.substeps),
+        (after.gridStride > before.gridStride) - (after.gridStride < before.gridStride),
+        (after.timeScale > before.timeScale) - (after.timeScale < before.timeScale)
+    };
+    bool late = frame >= frames/2;
+    for (int k = 0; k < 3; k++) {
+        if (move[k] == 0) continue;
+        if (late && t.lastMove[k] != 0 && move[k] != t.lastMove[k]) t.lateReversals++;
+        t.lastMove[k] = move[k];
+    }
+    t.lastChange = frame;
+    if (late) t.lateChanges++;
+}
+
+inline void LogGovernorRow(const char* label, const FrameGovernor& g, const GovernorTrace& t) {
+    TraceLog(LOG_INFO, "BENCH:   %-22s substeps %2d  grid x%d  time %3d%%  physics %5.1f + grid %5.1f ms  settled by frame %3d  late changes %d, reversals %d  %s",
+        label, g.substeps, g.gridStride, (int)(g.timeScale*100.0f), g.physicsMs, g.gridMs, t.lastChange,
+        t.lateChanges, t.lateReversals, (t.lateReversals == 0) ? "steady" : "OSCILLATES");
+}
+
+// Регулятор бюджета кадра: сначала на настоящих затратах физики (сетку не
+// рисуем) — лёгкие сцены поднимают подшаги до потолка; затем на заданных
+// затратах с шумом +-10%, которые заведомо не влезают в бюджет, чтобы
+// пройти вниз по всем рычагам: подшаги, сетка, темп времени.
+inline void BenchFrameGovernor(ThreadPool* pool) {
+    const int FRAMES = 600;
+    const int counts[] = { 250, 1000, 4000, 16000 };
+    TraceLog(LOG_INFO, "BENCH: frame governor, target %.0f ms, %d frames; disk scene, measured physics", BUDGET_TARGET_MS, FRAMES);
+    for (int count : counts) {
+        std::vector<Body> bodies;
+        LoadScene(bodies, SCENE_DISK, count);
+        GravityWorkspace ws;
+        ws.pool = pool;
+        GravitySettings settings = DefaultGravitySettings();
+        settings.solver = SceneSolver(SCENE_DISK);
+        FrameGovernor g = MakeFrameGovernor(BUDGET_TARGET_MS, 8, true);
+        GovernorTrace trace;
+        double owed = 0.0;  // тики, которые физика должна кадру (как аккумулятор FixedTimestep)
+        for (int frame = 0; frame < FRAMES; frame++) {
+            owed += (double)g.substeps*g.timeScale/LEAPFROG_STRIDE;
+            float dt = BASE_DT*LEAPFROG_STRIDE*8.0f/g.substeps;
+            double start = BenchNow();
+            for (; owed >= 1.0; owed -= 1.0) StepPhysics(bodies, dt, settings, ws);
+            FrameGovernor before = g;
+            if (UpdateFrameGovernor(g, (float)((BenchNow() - start)*1000.0), 0.0f)) TraceGovernorChange(trace, before, g, frame, FRAMES);
+        }
+        char label[32];
+        snprintf(label, sizeof(label), "%d bodies", count);
+        LogGovernorRow(label, g, trace);
+    }
+
+    // Затраты на кадр: физика пропорциональна подшагам и темпу, сетка — числу узлов
+    struct Load { const char* label; float substepMs; float gridMs; };
+    const Load loads[] = {
+        { "heavy physics", 4.0f, 1.0f },     // 8 подшагов = 32 мс: вниз по подшагам
+        { "heavy grid", 0.5f, 40.0f },       // сетка дороже физики: сначала реже сетка
+        { "heavy both", 6.0f, 30.0f },       // подшаги и сетка на пределе: темп времени
+        { "far over budget", 20.0f, 60.0f }, // упор в BUDGET_MIN_TIME_SCALE
+    };
+    TraceLog(LOG_INFO, "BENCH: frame governor, injected costs +-10%%");
+    for (const Load& load : loads) {
+        FrameGovernor g = MakeFrameGovernor(BUDGET_TARGET_MS, 8, true);
+        GovernorTrace trace;
+        unsigned int rng = 12345;
+        for (int frame = 0; frame < FRAMES; frame++) {
+            float noise[2];
+            for (float& n : noise) {
+                rng = rng*1664525u + 1013904223u;
+                n = 0.9f + 0.2f*(float)(rng >> 8)/(float)(1u << 24);
+            }
+            float physicsMs = load.substepMs*g.substeps*g.timeScale*noise[0];
+            float gridMs = load.gridMs/(float)(g.gridStride*g.gridStride)*noise[1];
+            FrameGovernor before = g;
+            if (UpdateFrameGovernor(g, physicsMs, gridMs)) TraceGovernorChange(trace, before, g, frame, FRAMES);
+        }
+        LogGovernorRow(load.label, g, trace);
+    }
+}
+
+// Касания: sweep and prune против хеша и перебора N^2, затем прогон диска
+// со слияниями и без — слияния уменьшают N и цену каждого вычисления сил
+inline void BenchCollisions(ThreadPool* pool) {
+    // Шаг за шагом, как в симуляции: тела дрейфуют по скоростям (без
+    // гравитации — меряем только broadphase), слияния идут по-настоящему
+    const int STEPS = 20;
+    TraceLog(LOG_INFO, "BENCH: collision broadphase, disk scene, %d drifting steps", STEPS);
+    const int counts[] = { 2000, 8000, 32000 };
+    for (int count : counts) {
+        std::vector<Body> start;
+        LoadScene(start, SCENE_DISK, count);
+        double ms[2];
+        long long swaps = 0;
+        int left = 0;
+        for (int mode = 0; mode < 2; mode++) {
+            CollisionState cs;
+            cs.broadphase = mode ? BROADPHASE_HASH : BROADPHASE_SWEEP;
+            std::vector<Body> bodies = start;
+            ResolveCollisions(bodies, cs);  // первая сборка и слияния исходных перекрытий
+            double total = 0.0;
+            for (int s = 0; s < STEPS; s++) {
+                BeginCollisionStep(cs, bodies);
+                for (Body& b : bodies) b.position = Vector3Add(b.position, Vector3Scale(b.velocity, BASE_DT));
+                double t0 = BenchNow();
+                ResolveCollisions(bodies, cs);
+                total += BenchNow() - t0;
+                if (mode == 0) swaps += cs.sap.swaps;
+            }
+            ms[mode] = total*1000.0/STEPS;
+            left = (int)bodies.size();
+        }
+        TraceLog(LOG_INFO, "BENCH:   %6d bodies  sweep %6.3f ms/step (%lld swaps)  hash %6.3f ms/step  bodies left %d",
+            count, ms[0], swaps/STEPS, ms[1], left);
+        if (count > 8000) continue;
+        int overlaps = 0;
+        double bruteMs = BenchBestMs(1, [&]() {
+            overlaps = 0;
+            for (size_t i = 0; i < start.size(); i++)
+                for (size_t j = i + 1; j < start.size(); j++) {
+                    float reach = start[i].radius + start[j].radius;
+                    if (Vector3DistanceSqr(start[i].position, start[j].position) < reach*reach) overlaps++;
+                }
+        });
+        TraceLog(LOG_INFO, "BENCH:           brute %8.2f ms  overlapping pairs at start %d", bruteMs, overlaps);
+    }
+
+    const float DURATION = 1.0f;
+    TraceLog(LOG_INFO, "BENCH: disk scene with 2000 bodies for %.1f time units", DURATION);
+    for (int collide = 1; collide >= 0; collide--) {
+        std::vector<Body> bodies;
+        LoadScene(bodies, SCENE_DISK, 2000);
+        GravityWorkspace ws;
+        ws.pool = pool;
+        GravitySettings settings = DefaultGravitySettings();
+        CollisionState cs;
+        float dt = BASE_DT*LEAPFROG_STRIDE;
+        int steps = (int)llround(DURATION/dt);
+        double t0 = BenchNow();
+        for (int s = 0; s < steps; s++) {
+            if (collide) BeginCollisionStep(cs, bodies);
+            StepPhysics(bodies, dt, settings, ws);
+            if (collide && ResolveCollisions(bodies, cs)) InvalidateAccelerationCache(ws);
+        }
+        TraceLog(LOG_INFO, "BENCH:   %-8s %8.1f ms  bodies left %d", collide ? "merging" : "passing", (BenchNow() - t0)*1000.0, (int)bodies.size());
+    }
+}
+
+// Быстрые тела: выстрел из строителя (скорость = протяжка*5) сквозь
+// планету радиуса 1. Прицельные параметры равномерно на [0, 2*reach):
+// попасть должна ровно половина. Фаза старта внутри шага у выстрелов
+// разная. Без непрерывной проверки при крупном шаге снаряд перепрыгивает цель.
+inline void BenchContinuousCollisions() {
+    const int SHOTS = 200;
+    const float SPEED = 1000.0f;  // протяжка 200
+    const float RANGE = 30.0f;
+    const int substepCounts[] = { 16, 8, 4, 2 };
+    TraceLog(LOG_INFO, "BENCH: continuous collisions, %d shots at speed %.0f through a radius 1 planet", SHOTS, SPEED);
+    for (int substeps : substepCounts) {
+        float dt = BASE_DT*LEAPFROG_STRIDE*8.0f/substeps;
+        int steps = (int)ceilf(2.0f*RANGE/(SPEED*dt));
+        int hits[2] = { 0, 0 };
+        for (int continuous = 0; continuous < 2; continuous++) {
+            for (int shot = 0; shot < SHOTS; shot++) {
+                float aim = 4.0f*(shot + 0.5f)/SHOTS;
+                float phase = fmodf(shot*0.618034f, 1.0f)*SPEED*dt;
+                std::vector<Body> bodies = {
+                    { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, 16.0f, 1.0f, WHITE, false },
+                    { { -RANGE - phase, aim, 0.0f }, { SPEED, 0.0f, 0.0f }, 16.0f, 1.0f, WHITE, false },
+                };
+                CollisionState cs;
+                cs.continuous = continuous;
+                for (int s = 0; s < steps && bodies.size() == 2; s++) {
+                    BeginCollisionStep(cs, bodies);
+                    for (Body& b : bodies) b.position = Vector3Add(b.position, Vector3Scale(b.velocity, dt));
+                    ResolveCollisions(bodies, cs);
+                }
+                if (bodies.size() == 1) hits[continuous]++;
+            }
+        }
+        TraceLog(LOG_INFO, "BENCH:   substeps %2d  %5.2f units/step  discrete %3d hits  continuous %3d hits  (expected %d)",
+            substeps, SPEED*dt, hits[0], hits[1], SHOTS/2);
+    }
+}
+
+// Долгая сессия после удара: к диску добавлены осколки, которые уходят
+// быстрее второй космической, и осколки, падающие на звезду. Без уборки
+// они остаются в сумме сил навсегда; с уборкой цена шага возвращается к
+// цене диска. Слияния выключены, чтобы мерить только уборку.
+inline void BenchCulling(ThreadPool* pool) {
+    const int DISK = 1000, EJECTA = 1000, INFALL = 300, STEPS = 1000, TAIL = 100;
+    std::vector<Body> start;
+    LoadScene(start, SCENE_DISK, DISK);
+    std::mt19937 rng(99u);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (int k = 0; k < EJECTA + INFALL; k++) {
+        float angle = 2.0f*PI*unit(rng);
+        Vector3 dir = { cosf(angle), (unit(rng) - 0.5f)*0.2f, sinf(angle) };
+        float r = 60.0f + 40.0f*unit(rng);
+        float escape = sqrtf(2.0f*G*5000.0f/r);
+        float speed = (k < EJECTA) ? escape*(1.5f + unit(rng)) : -0.5f*escape;
+        start.push_back({ Vector3Scale(dir, r), Vector3Scale(dir, speed), 0.5f, 0.3f, GRAY, false });
+    }
+    CullRules rules;
+    rules.maxDistance = 4000.0f;
+    rules.unboundDistance = 500.0f;
+    TraceLog(LOG_INFO, "BENCH: culling, disk %d + %d escaping + %d falling, %d steps", DISK, EJECTA, INFALL, STEPS);
+    for (int cull = 1; cull >= 0; cull--) {
+        SlotMap<Body> map;
+        AssignSlots(map, start);
+        GravityWorkspace ws;
+        ws.pool = pool;
+        GravitySettings settings = DefaultGravitySettings();
+        settings.solver = SceneSolver(SCENE_DISK);
+        CullState cs;
+        rules.enabled = cull;
+        float dt = BASE_DT*LEAPFROG_STRIDE;
+        double t0 = BenchNow(), tail = 0.0;
+        for (int s = 1; s <= STEPS; s++) {
+            if (s == STEPS - TAIL + 1) tail = BenchNow();
+            StepPhysics(map.dense, dt, settings, ws);
+            if (s % CULL_INTERVAL == 0 && CullBodies(map, rules, cs)) InvalidateAccelerationCache(ws);
+        }
+        double end = BenchNow();
+        TraceLog(LOG_INFO, "BENCH:   %-9s %8.1f ms  last %d steps %6.2f ms/step  bodies left %d (escaped %lld, absorbed %lld)",
+            cull ? "culling" : "keeping", (end - t0)*1000.0, TAIL, (end - tail)*1000.0/TAIL, (int)map.dense.size(), cs.escaped, cs.absorbed);
+    }
+}
+
+// Slot map против std::map: случайные вставки, удаления по ручке, пачки
+// RemoveSlotsAt (как уборка), сжатия RetainSlots (как слияния) и откаты к
+// сохранённой копии (как перемотка). Живые ручки должны находить свои
+// значения, мёртвые — ничего, даже когда их слот занят снова, а ручки из
+// отброшенного будущего — и после отката, и после новых вставок; from у
+// RemoveSlotsAt — прежнее место каждого элемента.
+inline void BenchSlotMap() {
+    const int OPS = 200000, CHECK_EVERY = 1000, KEYFRAME_OPS = 5000;
+    SlotMap<int> map, saved;
+    std::map<int, SlotHandle> live, savedLive;
+    std::vector<SlotHandle> dead;
+    std::vector<uint64_t> savedHandles;
+    size_t savedDead = 0;
+    std::vector<int> before, indices, from, survivors;
+    std::mt19937 rng(24u);
+    int inserted = 0, rewinds = 0;
+    long long lost = 0, stale = 0, misplaced = 0;
+    auto key = [](SlotHandle h) { return (uint64_t)h.slot << 32 | h.generation; };
+    auto bury = [&](int value) {
+        dead.push_back(live[value]);
+        live.erase(value);
+    };
+    double t0 = BenchNow();
+    for (int op = 1; op <= OPS; op++) {
+        if (op % KEYFRAME_OPS == 0) {
+            saved = map;
+            savedLive = live;
+            savedDead = dead.size();
+            savedHandles.clear();
+            for (const auto& entry : live) savedHandles.push_back(key(entry.second));
+            std::sort(savedHandles.begin(), savedHandles.end());
+        } else if (op > KEYFRAME_OPS && op % KEYFRAME_OPS == KEYFRAME_OPS/2) {
+            // Перемотка: выданное и удалённое после копии — отброшенное будущее,
+            // удалённые с тех пор, но жившие в копии, снова живы
+            std::vector<SlotHandle> future(dead.begin() + savedDead, dead.end());
+            dead.resize(savedDead);
+            for (const auto& entry : live) future.push_back(entry.second);
+            for (SlotHandle handle : future) {
+                if (!std::binary_search(savedHandles.begin(), savedHandles.end(), key(handle))) dead.push_back(handle);
+            }
+            RestoreSlots(map, saved);
+            live = savedLive;
+            rewinds++;
+            continue;
+        }
+        // Пачки редки, но режут по восьмой части: живых держится сотни
+        int kind = (int)(rng() % 1000);
+        if (kind < 600 || live.empty()) {
+            live[inserted] = InsertSlot(map, inserted);
+            inserted++;
+        } else if (kind < 996) {
+            auto it = std::next(live.begin(), rng() % live.size());
+            SlotHandle handle = it->second;
+            if (!RemoveSlot(map, handle)) lost++;
+            if (RemoveSlot(map, handle)) stale++;  // второй раз ручка уже ничего не значит
+            bury(it->first);
+        } else if (kind < 998) {
+            before = map.dense;
+            indices.clear();
+            for (size_t i = 0; i < before.size(); i++) if (rng() % 8 == 0) indices.push_back((int)i);
+            if (!indices.empty()) indices.push_back(indices.front());  // повтор не удаляет дважды
+            RemoveSlotsAt(map, indices, from);
+            if (from.size() != map.dense.size()) misplaced++;
+            for (size_t k = 0; k < map.dense.size() && k < from.size(); k++) {
+                if (map.dense[k] != before[from[k]]) misplaced++;
+            }
+            for (int i : indices) bury(before[i]);
+        } else {
+            before = map.dense;
+            survivors.clear();
+            for (size_t i = 0; i < before.size(); i++) if (rng() % 8 != 0) survivors.push_back((int)i);
+            for (size_t k = 0; k < survivors.size(); k++) map.dense[k] = before[survivors[k]];
+            map.dense.resize(survivors.size());
+            RetainSlots(map, survivors);
+            size_t k = 0;
+            for (size_t i = 0; i < before.size(); i++) {
+                if (k < survivors.size() && survivors[k] == (int)i) {
+                    if (SlotIndex(map, live[before[i]]) != (int)k) misplaced++;
+                    k++;
+                } else {
+                    bury(before[i]);
+                }
+            }
+        }
+        if (op % CHECK_EVERY == 0) {
+            if (map.dense.size() != live.size() || map.owners.size() != live.size()) lost++;
+            for (const auto& entry : live) {
+                int index = SlotIndex(map, entry.second);
+                if (index < 0 || map.dense[index] != entry.first) lost++;
+            }
+            for (SlotHandle handle : dead) {
+                if (SlotIndex(map, handle) >= 0) stale++;
+            }
+        }
+    }
+    double ms = (BenchNow() - t0)*1000.0;
+
+    // Тело родилось после кадра, камера взяла его ручку, перемотка к кадру.
+    // Слот свободен и уже несёт поколение следующего жильца: и простое
+    // копирование кадра, и RestoreSlots с новой вставкой должны дать -1.
+    SlotMap<int> scene;
+    for (int v = 0; v < 4; v++) InsertSlot(scene, v);
+    RemoveSlot(scene, SlotAt(scene, 1));
+    SlotMap<int> frame = scene;
+    SlotHandle reused = InsertSlot(scene, 100);  // занял освобождённый слот
+    SlotHandle grown = InsertSlot(scene, 101);   // новый слот за пределами кадра
+    SlotMap<int> copied = scene;
+    copied = frame;
+    int rewindHits = (SlotIndex(copied, reused) >= 0) + (SlotIndex(copied, grown) >= 0);
+    RestoreSlots(scene, frame);
+    rewindHits += (SlotIndex(scene, reused) >= 0) + (SlotIndex(scene, grown) >= 0);
+    InsertSlot(scene, 200);
+    InsertSlot(scene, 201);
+    rewindHits += (SlotIndex(scene, reused) >= 0) + (SlotIndex(scene, grown) >= 0);
+
+    TraceLog(LOG_INFO, "BENCH: slot map, %d random operations against std::map, rewind every %d", OPS, KEYFRAME_OPS);
+    TraceLog(LOG_INFO, "BENCH:   %8.1f ms  inserted %d  live %d  slots %d  dead handles %d  rewinds %d",
+        ms, inserted, (int)live.size(), (int)map.slots.size(), (int)dead.size(), rewinds);
+    TraceLog(LOG_INFO, "BENCH:   lost %lld  stale handles found %lld  misplaced %lld  rewound handles found %d of 6",
+        lost, stale, misplaced, rewindHits);
+}
+
+// Тела совпадают бит в бит (байты выравнивания за isFixed не в счёт)
+inline bool SameBodies(const std::vector<Body>& a, const std::vector<Body>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (memcmp(&a[i], &b[i], offsetof(Body, isFixed) + 1) != 0) return false;
+        if (memcmp(&a[i].positionLo, &b[i].positionLo, sizeof(Vector3)) != 0) return false;
+    }
+    return true;
+}
+
+// Линия времени: прогон на несколько ключевых кадров, перемотка назад в
+// середину интервала и досчёт вперёд до конца должны повторить исходный
+// прогон бит в бит. Каждая схема отдельно (Эрмиту — луны: на диске его
+// блочные шаги мельчат до секунд на прогон), плюс leapfrog со слияниями и
+// уборкой (летящие прочь и падающие на звезду тела).
+inline void BenchTimeline(ThreadPool* pool) {
+    const int COUNT = 300, EJECTA = 40, INFALL = 40;
+    const long long STEPS = 3*KEYFRAME_INTERVAL + KEYFRAME_INTERVAL/2, MARK = KEYFRAME_INTERVAL + KEYFRAME_INTERVAL/2;
+    struct Case { Integrator integrator; SceneId scene; bool events; };
+    const Case cases[] = {
+        { INTEGRATOR_EULER, SCENE_DISK, false }, { INTEGRATOR_LEAPFROG, SCENE_DISK, false },
+        { INTEGRATOR_ADAPTIVE, SCENE_DISK, false }, { INTEGRATOR_HERMITE, SCENE_MOONS, false },
+        { INTEGRATOR_WISDOM_HOLMAN, SCENE_DISK, false }, { INTEGRATOR_LEAPFROG, SCENE_DISK, true },
+    };
+    TraceLog(LOG_INFO, "BENCH: timeline, %d bodies, %lld steps, seek back to step %lld and replay", COUNT, STEPS, MARK);
+    for (const Case& c : cases) {
+        std::vector<Body> start;
+        LoadScene(start, c.scene, COUNT);
+        if (c.events) {
+            std::mt19937 rng(7u);
+            std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+            for (int k = 0; k < EJECTA + INFALL; k++) {
+                float angle = 2.0f*PI*unit(rng);
+                Vector3 dir = { cosf(angle), (unit(rng) - 0.5f)*0.2f, sinf(angle) };
+                float r = 60.0f + 40.0f*unit(rng);
+                float escape = sqrtf(2.0f*G*5000.0f/r);
+                float speed = (k < EJECTA) ? escape*(1.5f + unit(rng)) : -0.5f*escape;
+                start.push_back({ Vector3Scale(dir, r), Vector3Scale(dir, speed), 0.5f, 0.3f, GRAY, false });
+            }
+        }
+        GravitySettings gravity = DefaultGravitySettings();
+        gravity.solver = SceneSolver(c.scene);
+        gravity.integrator = c.integrator;
+        PhysicsSim sim;
+        sim.collide = c.events;
+        sim.cull.enabled = c.events;
+        sim.cull.unboundDistance = 500.0f;
+        StartPhysics(sim, start, gravity, pool, false);
+
+        std::vector<Body> mark, end;
+        double markTime = 0.0;
+        double t0 = BenchNow();
+        while (sim.stepIndex < STEPS) {
+            AdvancePhysics(sim);
+            if (sim.stepIndex == MARK) {
+                mark = sim.bodies.dense;
+                markTime = sim.time;
+            }
+        }
+        double runMs = (BenchNow() - t0)*1000.0;
+        end = sim.bodies.dense;
+        double endTime = sim.time;
+
+        t0 = BenchNow();
+        SeekTimeline(sim, markTime);
+        double backMs = (BenchNow() - t0)*1000.0;
+        bool backSame = sim.stepIndex == MARK && SameBodies(sim.bodies.dense, mark);
+        t0 = BenchNow();
+        SeekTimeline(sim, endTime);
+        double forwardMs = (BenchNow() - t0)*1000.0;
+        bool forwardSame = sim.stepIndex == STEPS && SameBodies(sim.bodies.dense, end);
+        TraceLog(LOG_INFO, "BENCH:   %-9s %-5s%s run %8.1f ms  back %6.1f ms %s  forward %6.1f ms %s  keyframes %d  bodies %d -> %d",
+            IntegratorName(c.integrator), SceneName(c.scene), c.events ? " +events" : "        ", runMs,
+            backMs, backSame ? "same" : "DIFFERS", forwardMs, forwardSame ? "same" : "DIFFERS",
+            sim.timeline.count, (int)start.size(), (int)end.size());
+        StopPhysics(sim);
+    }
+}
+
+inline void RunBenchmarks(ThreadPool* pool) {
+    BenchDirectKernels(4096);
+    BenchIsaDispatch(4096);
+    BenchForcePrecision(4096);
+    BenchDirectTiling(pool);
+    BenchThreads(pool, 16384);
+    BenchFloatingOrigin(2048);
+    BenchIntegrators(pool);
+    BenchBlockSteps(pool, 1000);
+    BenchWisdomHolman(pool);
+    BenchEncounters(pool, 1000);
+    BenchFrameGovernor(pool);
+    BenchCollisions(pool);
+    BenchContinuousCollisions();
+    BenchCulling(pool);
+    BenchSlotMap();
+    BenchTimeline(pool);
+    BenchFmmOrders(4000);
+    BenchSolverCrossover(pool);
+    BenchParticleMesh(pool, 32000);
+}
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef BLOCK_STEPS_H
+#define BLOCK_STEPS_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// --- БЛОЧНЫЕ ШАГИ ---
+// Общий планировщик для схем с собственным шагом у каждого тела. Шаг тела —
+// внешний шаг, делённый на степень двойки; время внутри внешнего шага —
+// целое число квантов 2^-BLOCK_MAX_LEVEL, так что совпадение времён
+// проверяется точно. Блок — ближайшее время, к которому подошёл конец шага
+// хотя бы одного тела; обновляются только такие тела (активный набор).
+// На конце внешнего шага все тела сходятся в одном времени.
+
+// Самый мелкий шаг — внешний / 2^12. Ограничение держит худший случай
+// (сближение почти в точку, сила без смягчения) в 4096 блоках на внешний шаг.
+const int BLOCK_MAX_LEVEL = 12;
+const uint64_t BLOCK_FULL = (uint64_t)1 << BLOCK_MAX_LEVEL;
+
+// Статистика последнего внешнего шага
+struct BlockStats {
+    int blocks;          // блоков (вычислений сил на активный набор)
+    long long updates;   // обновлений тел по всем блокам
+    int bodies;          // подвижных тел
+    int deepestLevel;    // самый мелкий шаг: внешний / 2^deepestLevel
+};
+
+// Средняя доля подвижных тел, обновлённых в блоке
+inline float ActiveFraction(const BlockStats& stats) {
+    if (stats.blocks <= 0 || stats.bodies <= 0) return 0.0f;
+    return (float)((double)stats.updates/((double)stats.blocks*stats.bodies));
+}
+
+struct BlockScheduler {
+    std::vector<uint64_t> time;  // кванты от начала внешнего шага
+    std::vector<uint64_t> step;  // кванты, степень двойки
+    std::vector<unsigned char> fixed;  // закреплённые тела не планируются
+    std::vector<int> active;
+    bool sharedStep = false;     // все тела на шаге самого быстрого (для сравнения)
+    BlockStats stats = { 0, 0, 0, 0 };
+};
+
+// Наибольший блочный шаг не длиннее want (в квантах — want/quantum), кратный времени t
+inline uint64_t QuantizeBlockStep(double want, double quantum, uint64_t t) {
+    uint64_t step = BLOCK_FULL;
+    while (step > 1 && (step*quantum > want || t % step != 0)) step >>= 1;
+    return step;
+}
+
+inline int BlockLevel(uint64_t step) {
+    int level = 0;
+    for (; step < BLOCK_FULL; step <<= 1) level++;
+    return level;
+}
+
+// Новый набор тел: все на нулевом времени, шаги выставит вызывающий
+inline void ResetBlockScheduler(BlockScheduler& s, const std::vector<unsigned char>& fixed) {
+    s.fixed = fixed;
+    s.time.assign(fixed.size(), 0);
+    s.step.assign(fixed.size(), BLOCK_FULL);
+    s.stats.bodies = (int)std::count(fixed.begin(), fixed.end(), (unsigned char)0);
+}
+
+inline void BeginBlockStats(BlockScheduler& s) {
+    s.stats.blocks = 0;
+    s.stats.updates = 0;
+    s.stats.deepestLevel = 0;
+    if (!s.sharedStep) return;
+    uint64_t smallest = BLOCK_FULL;
+    for (size_t i = 0; i < s.step.size(); i++) if (!s.fixed[i]) smallest = std::min(smallest, s.step[i]);
+    std::fill(s.step.begin(), s.step.end(), smallest);
+}
+
+// Время следующего блока; в s.active — тела, чей шаг кончается в нём.
+// Пустой набор — двигать нечего.
+inline uint64_t CollectActiveBodies(BlockScheduler& s) {
+    uint64_t next = BLOCK_FULL;
+    for (size_t i = 0; i < s.time.size(); i++) {
+        if (!s.fixed[i]) next = std::min(next, s.time[i] + s.step[i]);
+    }
+    s.active.clear();
+    for (size_t i = 0; i < s.time.size(); i++) {
+        if (!s.fixed[i] && s.time[i] + s.step[i] == next) s.active.push_back((int)i);
+    }
+    if (!s.active.empty()) {
+        s.stats.blocks++;
+        s.stats.updates += (long long)s.active.size();
+    }
+    return next;
+}
+
+// Тело i дошло до конца шага (time[i] уже сдвинут); want — желаемый шаг в
+// единицах времени. Шаг мельчает сразу, растёт не больше чем вдвое и только
+// там, где удвоенный шаг ложится на сетку блоков.
+inline void AdaptBlockStep(BlockScheduler& s, int i, double want, double quantum) {
+    uint64_t grown = s.step[i]*2;
+    if (grown <= BLOCK_FULL && grown*quantum <= want && s.time[i] % grown == 0) s.step[i] = grown;
+    else if (s.step[i]*quantum > want) s.step[i] = QuantizeBlockStep(want, quantum, s.time[i]);
+}
+
+// После обработки блока: общий шаг и самый глубокий уровень
+inline void FinishBlock(BlockScheduler& s) {
+    if (s.sharedStep) {
+        uint64_t smallest = BLOCK_FULL;
+        for (int i : s.active) smallest = std::min(smallest, s.step[i]);
+        std::fill(s.step.begin(), s.step.end(), smallest);
+    }
+    for (int i : s.active) s.stats.deepestLevel = std::max(s.stats.deepestLevel, BlockLevel(s.step[i]));
+}
+
+// Внешний шаг закончен: следующий начинается с нуля
+inline void EndBlockStep(BlockScheduler& s) {
+    std::fill(s.time.begin(), s.time.end(), 0);
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef BODY_STORE_H
+#define BODY_STORE_H
+
+#include "gravity.h"
+#include <vector>
+#include <new>
+#include <cstddef>
+
+// --- SoA-ХРАНИЛИЩЕ ТЕЛ ---
+// Отдельные выровненные массивы координат для векторных ядер.
+// Длина дополняется до BODY_STORE_WIDTH, хвост — тела с нулевой массой.
+// Координаты хранятся относительно центра набора (center) вместе с младшей
+// частью positionLo, так что ядра считают в float на малых смещениях.
+
+const size_t BODY_STORE_ALIGN = 64;  // линия кэша и ширина AVX-512
+const size_t BODY_STORE_WIDTH = 16;  // самая широкая векторная ширина (AVX-512, float)
+
+template <typename T>
+struct AlignedAllocator {
+    typedef T value_type;
+
+    AlignedAllocator() = default;
+    template <typename U> AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n*sizeof(T), std::align_val_t(BODY_STORE_ALIGN)));
+    }
+    void deallocate(T* p, size_t) {
+        ::operator delete(p, std::align_val_t(BODY_STORE_ALIGN));
+    }
+    template <typename U> bool operator==(const AlignedAllocator<U>&) const { return true; }
+    template <typename U> bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+typedef std::vector<float, AlignedAllocator<float>> AlignedFloats;
+
+struct BodyStore {
+    size_t count;   // реальное число тел
+    size_t padded;  // count, округлённый вверх до BODY_STORE_WIDTH
+    AlignedFloats x, y, z;
+    AlignedFloats vx, vy, vz;
+    AlignedFloats m;
+    std::vector<unsigned char> fixed;  // закреплённые тела притягивают, но не ускоряются
+    double center[3];  // точка отсчёта x, y, z в координатах тел
+};
+
+inline size_t PadToWidth(size_t n) {
+    return (n + BODY_STORE_WIDTH - 1) / BODY_STORE_WIDTH * BODY_STORE_WIDTH;
+}
+
+inline void PackBodies(const std::vector<Body>& bodies, BodyStore& store) {
+    store.count = bodies.size();
+    store.padded = PadToWidth(bodies.size());
+    AlignedFloats* arrays[] = { &store.x, &store.y, &store.z, &store.vx, &store.vy, &store.vz, &store.m };
+    for (AlignedFloats* a : arrays) a->assign(store.padded, 0.0f);
+    store.fixed.assign(store.padded, 1);
+
+    double sum[3] = { 0.0, 0.0, 0.0 };
+    for (const Body& b : bodies) { sum[0] += b.position.x; sum[1] += b.position.y; sum[2] += b.position.z; }
+    for (int a = 0; a < 3; a++) store.center[a] = bodies.empty() ? 0.0 : sum[a]/bodies.size();
+
+    for (size_t i = 0; i < bodies.size(); i++) {
+        const Body& b = bodies[i];
+        store.x[i] = (float)(((double)b.position.x - store.center[0]) + b.positionLo.x);
+        store.y[i] = (float)(((double)b.position.y - store.center[1]) + b.positionLo.y);
+        store.z[i] = (float)(((double)b.position.z - store.center[2]) + b.positionLo.z);
+        store.vx[i] = b.velocity.x; store.vy[i] = b.velocity.y; store.vz[i] = b.velocity.z;
+        store.m[i] = b.mass;
+        store.fixed[i] = b.isFixed ? 1 : 0;
+    }
+}
+
+#endif
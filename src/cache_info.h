@@ -0,0 +1,74 @@
+#ifndef CACHE_INFO_H
+#define CACHE_INFO_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__linux__)
+    #include <unistd.h>
+#endif
+
+// --- РАЗМЕРЫ КЭША ---
+// Сначала sysconf (glibc), затем sysfs (Android и прочие libc, где sysconf
+// отдаёт 0), иначе — типичные значения для мобильных и настольных ядер.
+
+struct CacheSizes {
+    size_t l1d;  // байт данных L1 на ядро
+    size_t l2;
+    size_t l3;   // 0, если нет
+    bool detected;
+};
+
+// Строка вида "48K", "2048K", "8M"
+inline size_t ParseCacheSize(const char* text) {
+    char* end = nullptr;
+    size_t value = (size_t)strtoul(text, &end, 10);
+    if (end && (*end == 'K' || *end == 'k')) value *= 1024;
+    else if (end && (*end == 'M' || *end == 'm')) value *= 1024*1024;
+    return value;
+}
+
+inline bool ReadSysfsLine(const char* path, char* buffer, int size) {
+    FILE* file = fopen(path, "r");
+    if (!file) return false;
+    bool ok = fgets(buffer, size, file) != nullptr;
+    fclose(file);
+    return ok;
+}
+
+inline CacheSizes DetectCacheSizes() {
+    CacheSizes sizes = { 32*1024, 512*1024, 0, false };
+#if defined(__linux__)
+    #if defined(_SC_LEVEL1_DCACHE_SIZE)
+    long l1 = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+    long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (l1 > 0 && l2 > 0) {
+        sizes = { (size_t)l1, (size_t)l2, (l3 > 0) ? (size_t)l3 : 0, true };
+        return sizes;
+    }
+    #endif
+    for (int index = 0; index < 8; index++) {
+        char path[128], level[16], type[32], size[32];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", index);
+        if (!ReadSysfsLine(path, level, sizeof(level))) break;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", index);
+        if (!ReadSysfsLine(path, type, sizeof(type))) continue;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", index);
+        if (!ReadSysfsLine(path, size, sizeof(size))) continue;
+        if (strncmp(type, "Instruction", 11) == 0) continue;
+        size_t bytes = ParseCacheSize(size);
+        if (bytes == 0) continue;
+        switch (atoi(level)) {
+            case 1: sizes.l1d = bytes; sizes.detected = true; break;
+            case 2: sizes.l2 = bytes; break;
+            case 3: sizes.l3 = bytes; break;
+            default: break;
+        }
+    }
+#endif
+    return sizes;
+}
+
+#endif
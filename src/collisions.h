@@ -0,0 +1,234 @@
+#ifndef COLLISIONS_H
+#define COLLISIONS_H
+
+#include "gravity.h"
+#include "floating_origin.h"
+#include "spatial_hash.h"
+#include "sweep_and_prune.h"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+// --- СТОЛКНОВЕНИЯ И СЛИЯНИЯ ---
+// Тела, чьи сферы пересеклись, сливаются неупруго: масса складывается,
+// импульс сохраняется, центр масс остаётся на месте. Кандидатов даёт
+// broadphase (а не перебор N^2), два на выбор:
+//   sweep — постоянный sweep and prune (sweep_and_prune.h): живёт между
+//           шагами и обновляется за O(N + перестановок), основной;
+//   hash  — пространственный хеш, построенный заново на каждом шаге:
+//           ячейка — два типичных радиуса, касание двух тел сетки видно из
+//           27 соседних ячеек, редкие крупные тела (звезда) идут списком.
+// Цепочки касаний (A задел B, B задел C) собираются в одну группу через
+// систему непересекающихся множеств; итог от порядка пар не зависит.
+// Закреплённое тело поглощает группу и остаётся на месте неподвижным.
+// Быстрое тело (за шаг сместилось больше своего радиуса) может проскочить
+// цель между двумя проверками. Для него касание ищется непрерывно: сфера
+// идёт по отрезку от позиции в начале шага (BeginCollisionStep) к концу,
+// и проверяется ближайшее сближение на всём отрезке. Слияние всё равно
+// происходит в конце шага, в центре масс группы.
+
+enum CollisionBroadphase {
+    BROADPHASE_SWEEP,
+    BROADPHASE_HASH
+};
+
+struct CollisionState {
+    CollisionBroadphase broadphase = BROADPHASE_SWEEP;
+    SweepAndPrune sap;
+    SpatialHash grid;
+    std::vector<int> parent;     // система непересекающихся множеств
+    std::vector<float> radii;    // для выбора ячейки
+    std::vector<Vector3> start;  // позиции в начале шага
+    std::vector<Vector3> from;   // откуда тело шло: start у быстрых, иначе конец шага
+    std::vector<unsigned char> swept;  // быстрое тело
+    bool continuous = true;      // непрерывная проверка быстрых тел
+    int sweptBodies = 0;         // быстрых на последнем шаге
+    std::vector<int> survivors;  // новый индекс -> старый после последнего слияния
+    int merged = 0;              // тел поглощено на последнем шаге
+    long long totalMerged = 0;
+};
+
+inline int FindCollisionRoot(std::vector<int>& parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];  // сокращение пути через одного
+        i = parent[i];
+    }
+    return i;
+}
+
+// Корень — самое тяжёлое тело группы (закреплённое — тяжелее любого подвижного)
+inline bool CollisionHeavier(const Body& a, const Body& b) {
+    if (a.isFixed != b.isFixed) return a.isFixed;
+    return a.mass > b.mass;
+}
+
+// Отрезки движения двух сфер: ближайшее сближение за шаг (t в [0, 1])
+// в относительной системе, где одна сфера покоится, а другая идёт по прямой
+inline bool SweptSpheresTouch(Vector3 from1, Vector3 to1, Vector3 from2, Vector3 to2, float reach) {
+    Vector3 d = Vector3Subtract(from1, from2);
+    Vector3 e = Vector3Subtract(Vector3Subtract(to1, to2), d);
+    float ee = Vector3DotProduct(e, e);
+    float t = (ee > 0.0f) ? std::clamp(-Vector3DotProduct(d, e)/ee, 0.0f, 1.0f) : 0.0f;
+    Vector3 closest = Vector3Add(d, Vector3Scale(e, t));
+    return Vector3LengthSqr(closest) < reach*reach;
+}
+
+inline void UniteColliding(std::vector<Body>& bodies, CollisionState& cs, int i, int j) {
+    if (bodies[i].isFixed && bodies[j].isFixed) return;  // две звезды не трогаем
+    float reach = bodies[i].radius + bodies[j].radius;
+    if (cs.swept[i] || cs.swept[j]) {
+        if (!SweptSpheresTouch(cs.from[i], bodies[i].position, cs.from[j], bodies[j].position, reach)) return;
+    } else {
+        Vector3 d = Vector3Subtract(bodies[i].position, bodies[j].position);
+        if (Vector3LengthSqr(d) >= reach*reach) return;
+    }
+    int a = FindCollisionRoot(cs.parent, i), b = FindCollisionRoot(cs.parent, j);
+    if (a == b) return;
+    bool bHeavier = CollisionHeavier(bodies[b], bodies[a]);
+    if (bHeavier || (!CollisionHeavier(bodies[a], bodies[b]) && b < a)) std::swap(a, b);  // равные — меньший индекс
+    cs.parent[b] = a;
+}
+
+// Радиус растёт как sqrt(массы) — закон строителя планет (sqrt(mass)/4), но
+// от радиуса самого тяжёлого члена: у тел сцен своя плотность, и звезда
+// радиуса 10 от пылинки не должна раздуваться до sqrt(5000)/4
+inline float MergedRadius(const Body& heaviest, float mass) {
+    return heaviest.radius*sqrtf(mass/heaviest.mass);
+}
+
+// Перед шагом: запомнить позиции для непрерывной проверки
+inline void BeginCollisionStep(CollisionState& cs, const std::vector<Body>& bodies) {
+    cs.start.resize(bodies.size());
+    for (size_t i = 0; i < bodies.size(); i++) cs.start[i] = bodies[i].position;
+}
+
+// Быстрые тела шага и откуда они шли. Без BeginCollisionStep (или после
+// смены состава тел) все считаются неподвижными в конце шага.
+inline void MarkSweptBodies(const std::vector<Body>& bodies, CollisionState& cs) {
+    size_t n = bodies.size();
+    bool known = cs.continuous && cs.start.size() == n;
+    cs.from.resize(n);
+    cs.swept.assign(n, 0);
+    cs.sweptBodies = 0;
+    for (size_t i = 0; i < n; i++) {
+        const Body& b = bodies[i];
+        cs.from[i] = b.position;
+        if (!known || Vector3DistanceSqr(cs.start[i], b.position) <= b.radius*b.radius) continue;
+        cs.from[i] = cs.start[i];
+        cs.swept[i] = 1;
+        cs.sweptBodies++;
+    }
+    cs.start.clear();  // на один шаг
+}
+
+// Пары-кандидаты из хеша, построенного заново
+inline void UniteCollidingHashed(std::vector<Body>& bodies, CollisionState& cs) {
+    size_t n = bodies.size();
+    // Ячейка — два радиуса 90-го перцентиля: почти все тела в сетке
+    cs.radii.resize(n);
+    for (size_t i = 0; i < n; i++) cs.radii[i] = bodies[i].radius;
+    size_t pick = n*9/10;
+    std::nth_element(cs.radii.begin(), cs.radii.begin() + pick, cs.radii.end());
+    float cell = fmaxf(2.0f*cs.radii[pick], 1e-3f);
+    float half = 0.5f*cell;
+    BuildSpatialHash(cs.grid, bodies, cell, [&](int i) { return bodies[i].radius > half; });
+
+    for (size_t i = 0; i < n; i++) {
+        if (bodies[i].radius > half) continue;
+        ForEachInSpatialHash(cs.grid, bodies[i].position, 1, [&](int j) {
+            if (j > (int)i) UniteColliding(bodies, cs, (int)i, j);
+        });
+    }
+    // Крупное тело: куб ячеек на свой радиус, а если он больше всей сцены —
+    // перебор. Между собой крупные — перебором, каждая пара раз.
+    const std::vector<int>& large = cs.grid.large;
+    for (size_t k = 0; k < large.size(); k++) {
+        int big = large[k];
+        int span = (int)ceilf((bodies[big].radius + half)/cell);
+        size_t cells = (size_t)(2*span + 1)*(2*span + 1)*(2*span + 1);
+        if (cells < n) {
+            ForEachInSpatialHash(cs.grid, bodies[big].position, span, [&](int j) { UniteColliding(bodies, cs, big, j); });
+        } else {
+            for (size_t j = 0; j < n; j++) {
+                if (bodies[j].radius <= half) UniteColliding(bodies, cs, big, (int)j);
+            }
+        }
+        for (size_t m = k + 1; m < large.size(); m++) UniteColliding(bodies, cs, big, large[m]);
+    }
+    // Путь быстрого тела в ячейку не помещается — перебор, быстрых единицы
+    if (cs.sweptBodies == 0) return;
+    for (size_t i = 0; i < n; i++) {
+        if (!cs.swept[i]) continue;
+        for (size_t j = 0; j < n; j++) {
+            if (j != i && (!cs.swept[j] || j > i)) UniteColliding(bodies, cs, (int)i, (int)j);
+        }
+    }
+}
+
+// Пары-кандидаты — пересекающиеся коробки sweep and prune
+inline void UniteCollidingSwept(std::vector<Body>& bodies, CollisionState& cs) {
+    UpdateSweepAndPrune(cs.sap, bodies, cs.from);
+    for (uint64_t key : cs.sap.pairs) UniteColliding(bodies, cs, (int)(key >> 32), (int)(key & 0xffffffffu));
+}
+
+// Один проход после шага: находит касания и сливает группы. true — тела
+// убраны (индексы сдвинулись: см. cs.survivors, кэши схем устарели).
+inline bool ResolveCollisions(std::vector<Body>& bodies, CollisionState& cs) {
+    size_t n = bodies.size();
+    cs.merged = 0;
+    if (n < 2) {
+        cs.start.clear();
+        return false;
+    }
+
+    MarkSweptBodies(bodies, cs);
+    cs.parent.resize(n);
+    for (size_t i = 0; i < n; i++) cs.parent[i] = (int)i;
+    if (cs.broadphase == BROADPHASE_SWEEP) UniteCollidingSwept(bodies, cs);
+    else UniteCollidingHashed(bodies, cs);
+
+    // Суммы групп в корнях, в double: масса, импульс, масса*положение
+    struct Sum { double mass, p[3], x[3]; };
+    std::vector<Sum> sums;
+    bool any = false;
+    for (size_t i = 0; i < n && !any; i++) any = cs.parent[i] != (int)i;
+    if (!any) return false;
+    sums.assign(n, Sum{ 0.0, { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 } });
+    for (size_t i = 0; i < n; i++) {
+        Sum& s = sums[FindCollisionRoot(cs.parent, (int)i)];
+        const Body& b = bodies[i];
+        double x[3];
+        BodyOffset(b, x);
+        s.mass += b.mass;
+        s.p[0] += (double)b.mass*b.velocity.x;
+        s.p[1] += (double)b.mass*b.velocity.y;
+        s.p[2] += (double)b.mass*b.velocity.z;
+        for (int c = 0; c < 3; c++) s.x[c] += b.mass*x[c];
+    }
+
+    // Корни остаются на своих местах в порядке индексов, остальные уходят
+    cs.survivors.clear();
+    for (size_t i = 0; i < n; i++) {
+        if (cs.parent[i] != (int)i) continue;
+        Body b = bodies[i];
+        const Sum& s = sums[i];
+        if (s.mass != (double)b.mass) {
+            if (!b.isFixed) {
+                SetBodyOffset(b, s.x[0]/s.mass, s.x[1]/s.mass, s.x[2]/s.mass);
+                b.velocity = { (float)(s.p[0]/s.mass), (float)(s.p[1]/s.mass), (float)(s.p[2]/s.mass) };
+            }
+            b.radius = MergedRadius(bodies[i], (float)s.mass);
+            b.mass = (float)s.mass;
+        }
+        bodies[cs.survivors.size()] = b;
+        cs.survivors.push_back((int)i);
+    }
+    cs.merged = (int)(n - cs.survivors.size());
+    cs.totalMerged += cs.merged;
+    bodies.resize(cs.survivors.size());
+    if (cs.broadphase == BROADPHASE_SWEEP) RemapSweepAndPrune(cs.sap, cs.survivors);
+    else InvalidateSweepAndPrune(cs.sap);
+    return true;
+}
+
+#endif
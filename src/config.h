@@ -0,0 +1,173 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include "raylib.h"
+#include "gravity.h"
+#include "scenes.h"
+#include "cpu_features.h"
+#include "frame_budget.h"
+#include "culling.h"
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+
+// --- НАСТРОЙКИ ЗАПУСКА ---
+struct AppConfig {
+    GravitySettings gravity;
+    SceneId scene;
+    int bodyCount;  // число тел для генерируемых сцен
+    bool benchmark; // прогнать бенчмарки без окна и выйти
+    int threads;    // потоков физики вместе с основным (0 = по числу ядер)
+    std::vector<int> pinCpus;  // ядра для рабочих потоков, пусто = без привязки
+    GravityIsa isa;  // набор команд ядер; ISA_COUNT = лучший доступный
+    bool physicsThread;  // false = физика в цикле кадра (отладка, веб)
+    float frameBudgetMs; // цель регулятора: физика + сетка за кадр
+    bool governor;       // false = подшаги и сетка постоянны
+    bool collisions;     // сливать касающиеся тела
+    CullRules cull;      // уборка улетевших и упавших в звезду
+};
+
+inline AppConfig DefaultAppConfig() {
+    AppConfig config;
+    config.gravity = DefaultGravitySettings();
+    config.scene = SCENE_DEFAULT;
+    config.bodyCount = 1000;
+    config.benchmark = false;
+    config.threads = 0;
+    config.isa = ISA_COUNT;
+    config.physicsThread = true;
+    config.frameBudgetMs = BUDGET_TARGET_MS;
+    config.governor = true;
+    config.collisions = true;
+    config.cull = CullRules();
+    return config;
+}
+
+inline bool ParseSolverName(const char* name, GravitySolver* solver) {
+    for (int s = 0; s < SOLVER_COUNT; s++) {
+        if (strcmp(name, GravitySolverName((GravitySolver)s)) == 0) { *solver = (GravitySolver)s; return true; }
+    }
+    return false;
+}
+
+inline bool ParseIntegratorName(const char* name, Integrator* integrator) {
+    for (int k = 0; k < INTEGRATOR_COUNT; k++) {
+        if (strcmp(name, IntegratorName((Integrator)k)) == 0) { *integrator = (Integrator)k; return true; }
+    }
+    return false;
+}
+
+// Список ядер вида "0,2,4-7"
+inline std::vector<int> ParseCpuList(const char* text) {
+    std::vector<int> cpus;
+    const char* p = text;
+    while (*p) {
+        char* end = nullptr;
+        long first = strtol(p, &end, 10);
+        if (end == p) break;
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (long c = first; c <= last; c++) cpus.push_back((int)c);
+        if (*p == ',') p++;
+    }
+    return cpus;
+}
+
+// Аргументы вида "--solver bh --theta 0.5"; неизвестные пропускаем с предупреждением
+inline void ParseCommandLine(int argc, char** argv, AppConfig* config) {
+    bool solverSet = false;
+    bool integratorSet = false;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (strcmp(arg, "--solver") == 0 && value) {
+            if (ParseSolverName(value, &config->gravity.solver)) solverSet = true;
+            else TraceLog(LOG_WARNING, "Unknown solver: %s", value);
+            i++;
+        } else if (strcmp(arg, "--theta") == 0 && value) {
+            config->gravity.theta = (float)atof(value);
+            i++;
+        } else if (strcmp(arg, "--leaf-size") == 0 && value) {
+            config->gravity.leafSize = atoi(value);
+            i++;
+        } else if (strcmp(arg, "--fmm-order") == 0 && value) {
+            config->gravity.fmmOrder = atoi(value);
+            i++;
+        } else if (strcmp(arg, "--fmm-leaf") == 0 && value) {
+            config->gravity.fmmLeafSize = atoi(value);
+            i++;
+        } else if (strcmp(arg, "--pm-grid") == 0 && value) {
+            config->gravity.pmGrid = atoi(value);
+            i++;
+        } else if (strcmp(arg, "--pm-boundary") == 0 && value) {
+            if (strcmp(value, "periodic") == 0) config->gravity.pmBoundary = PM_PERIODIC;
+            else if (strcmp(value, "isolated") == 0) config->gravity.pmBoundary = PM_ISOLATED;
+            else TraceLog(LOG_WARNING, "Unknown PM boundary: %s", value);
+            i++;
+        } else if (strcmp(arg, "--pm-box") == 0 && value) {
+            config->gravity.pmBoxSize = (float)atof(value);
+            i++;
+        } else if (strcmp(arg, "--integrator") == 0 && value) {
+            if (ParseIntegratorName(value, &config->gravity.integrator)) integratorSet = true;
+            else TraceLog(LOG_WARNING, "Unknown integrator: %s", value);
+            i++;
+        } else if (strcmp(arg, "--tolerance") == 0 && value) {
+            config->gravity.tolerance = (float)atof(value);
+            i++;
+        } else if (strcmp(arg, "--scene") == 0 && value) {
+            if (!ParseSceneName(value, &config->scene)) TraceLog(LOG_WARNING, "Unknown scene: %s", value);
+            i++;
+        } else if (strcmp(arg, "--bodies") == 0 && value) {
+            config->bodyCount = atoi(value);
+            if (config->scene == SCENE_DEFAULT) config->scene = SCENE_DISK;
+            i++;
+        } else if (strcmp(arg, "--threads") == 0 && value) {
+            config->threads = atoi(value);
+            i++;
+        } else if (strcmp(arg, "--pin") == 0 && value) {
+            config->pinCpus = ParseCpuList(value);
+            i++;
+        } else if (strcmp(arg, "--isa") == 0 && value) {
+            if (!ParseIsaName(value, &config->isa)) TraceLog(LOG_WARNING, "Unknown ISA: %s", value);
+            i++;
+        } else if (strcmp(arg, "--no-regularize") == 0) {
+            config->gravity.regularize = false;
+        } else if (strcmp(arg, "--tiled-direct") == 0) {
+            config->gravity.tiledDirect = true;
+        } else if (strcmp(arg, "--target-ms") == 0 && value) {
+            config->frameBudgetMs = (float)atof(value);
+            i++;
+        } else if (strcmp(arg, "--no-collisions") == 0) {
+            config->collisions = false;
+        } else if (strcmp(arg, "--no-cull") == 0) {
+            config->cull.enabled = false;
+        } else if (strcmp(arg, "--cull-distance") == 0 && value) {
+            config->cull.maxDistance = (float)atof(value);
+            i++;
+        } else if (strcmp(arg, "--escape-distance") == 0 && value) {
+            config->cull.unboundDistance = (float)atof(value);
+            i++;
+        } else if (strcmp(arg, "--no-absorb") == 0) {
+            config->cull.absorb = false;
+        } else if (strcmp(arg, "--no-absorb-mass") == 0) {
+            config->cull.absorbMass = false;
+        } else if (strcmp(arg, "--no-governor") == 0) {
+            config->governor = false;
+        } else if (strcmp(arg, "--inline-physics") == 0) {
+            config->physicsThread = false;
+        } else if (strcmp(arg, "--bench") == 0) {
+            config->benchmark = true;
+        } else {
+            TraceLog(LOG_WARNING, "Unknown argument: %s", arg);
+        }
+    }
+    if (!solverSet) config->gravity.solver = SceneSolver(config->scene);
+    if (!integratorSet) config->gravity.integrator = SceneIntegrator(config->scene);
+}
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#include "raylib.h"
+#include <cstring>
+#include <cstdlib>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define GRAVITY_X86 1
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+    #define GRAVITY_NEON 1  // на AArch64 NEON есть всегда (и с делением/корнем)
+#endif
+
+// Ядра для других наборов команд собираются в том же бинарнике с атрибутом
+// target, без -march; какое из них работает, решается при запуске.
+#if defined(__GNUC__) || defined(__clang__)
+    #define GRAVITY_TARGET(isa) __attribute__((target(isa)))
+#else
+    #define GRAVITY_TARGET(isa)
+#endif
+
+// --- НАБОРЫ КОМАНД ---
+enum GravityIsa {
+    ISA_SCALAR = 0,
+    ISA_SSE2,
+    ISA_AVX2,
+    ISA_AVX512,
+    ISA_NEON,
+    ISA_COUNT
+};
+
+inline const char* IsaName(GravityIsa isa) {
+    switch (isa) {
+        case ISA_SCALAR: return "scalar";
+        case ISA_SSE2: return "sse2";
+        case ISA_AVX2: return "avx2";
+        case ISA_AVX512: return "avx512";
+        case ISA_NEON: return "neon";
+        default: return "?";
+    }
+}
+
+inline bool ParseIsaName(const char* name, GravityIsa* isa) {
+    for (int i = 0; i < ISA_COUNT; i++) {
+        if (strcmp(name, IsaName((GravityIsa)i)) == 0) { *isa = (GravityIsa)i; return true; }
+    }
+    return false;
+}
+
+// Векторная ширина ядра в float
+inline int IsaLanes(GravityIsa isa) {
+    switch (isa) {
+        case ISA_SSE2: return 4;
+        case ISA_AVX2: return 8;
+        case ISA_AVX512: return 16;
+        case ISA_NEON: return 4;
+        default: return 1;
+    }
+}
+
+#if defined(GRAVITY_X86)
+inline void CpuId(unsigned int leaf, unsigned int sub, unsigned int regs[4]) {
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, (int)leaf, (int)sub);
+    for (int i = 0; i < 4; i++) regs[i] = (unsigned int)r[i];
+#else
+    regs[0] = regs[1] = regs[2] = regs[3] = 0;
+    __cpuid_count(leaf, sub, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Какие регистры ОС сохраняет при переключении потоков (XCR0)
+inline unsigned long long ReadXcr0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int lo = 0, hi = 0;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((unsigned long long)hi << 32) | lo;
+#endif
+}
+#endif
+
+// Поддерживает ли процессор (и ОС) этот набор
+inline bool IsaSupported(GravityIsa isa) {
+    if (isa == ISA_SCALAR) return true;
+#if defined(GRAVITY_X86)
+    unsigned int regs[4];
+    CpuId(0, 0, regs);
+    unsigned int maxLeaf = regs[0];
+    CpuId(1, 0, regs);
+    bool sse2 = (regs[3] & (1u << 26)) != 0;
+    bool osxsave = (regs[2] & (1u << 27)) != 0;
+    bool avx = (regs[2] & (1u << 28)) != 0;
+    if (isa == ISA_SSE2) return sse2;
+    if (!osxsave || !avx || maxLeaf < 7) return false;
+    unsigned long long xcr0 = ReadXcr0();
+    bool ymmState = (xcr0 & 0x6) == 0x6;     // XMM + YMM
+    bool zmmState = (xcr0 & 0xe6) == 0xe6;   // + opmask, ZMM0-15, ZMM16-31
+    CpuId(7, 0, regs);
+    if (isa == ISA_AVX2) return ymmState && (regs[1] & (1u << 5)) != 0;
+    if (isa == ISA_AVX512) return zmmState && (regs[1] & (1u << 16)) != 0;
+    return false;
+#elif defined(GRAVITY_NEON)
+    return isa == ISA_NEON;
+#else
+    return false;
+#endif
+}
+
+inline GravityIsa DetectBestIsa() {
+    const GravityIsa order[] = { ISA_AVX512, ISA_AVX2, ISA_SSE2, ISA_NEON };
+    for (GravityIsa isa : order) if (IsaSupported(isa)) return isa;
+    return ISA_SCALAR;
+}
+
+// Выбранный набор; ядра читают его на каждом вызове
+inline GravityIsa& ActiveIsaRef() {
+    static GravityIsa isa = DetectBestIsa();
+    return isa;
+}
+
+inline GravityIsa ActiveIsa() {
+    return ActiveIsaRef();
+}
+
+// Принудительный выбор (для A/B-замеров). Неподдерживаемый набор не включается.
+inline bool SelectIsa(GravityIsa isa) {
+    if (!IsaSupported(isa)) {
+        TraceLog(LOG_WARNING, "CPU: %s is not supported here, keeping %s", IsaName(isa), IsaName(ActiveIsa()));
+        return false;
+    }
+    ActiveIsaRef() = isa;
+    return true;
+}
+
+// Переменная окружения GRAVITY_ISA=sse2|avx2|... перекрывает автовыбор
+inline void ApplyIsaEnvironment() {
+    const char* value = getenv("GRAVITY_ISA");
+    if (!value || !*value) return;
+    GravityIsa isa;
+    if (ParseIsaName(value, &isa)) SelectIsa(isa);
+    else TraceLog(LOG_WARNING, "CPU: unknown GRAVITY_ISA=%s", value);
+}
+
+#endif
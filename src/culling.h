@@ -0,0 +1,112 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include "gravity.h"
+#include "floating_origin.h"
+#include "slot_map.h"
+#include "collisions.h"
+#include <vector>
+#include <cmath>
+
+// --- УБОРКА ТЕЛ ---
+// Тела, которые сцене больше ничего не дают, но каждый шаг стоят своей
+// доли N^2: улетевшие и упавшие в закреплённое тело. Правила:
+//   дальность — дальше maxDistance от центра масс системы;
+//   уход     — дальше unboundDistance, удаляется и полная энергия
+//              относительно системы положительна (система — точка с её
+//              массой: так далеко это честно), обратно не вернётся;
+//   падение  — центр внутри закреплённого тела; масса по желанию
+//              добавляется поглотителю.
+// Проход идёт раз в CULL_INTERVAL шагов и убирает всех найденных одной
+// пачкой обменов с последним (RemoveSlotsAt): порядок тел не сохраняется,
+// зато пачка стоит O(убранных), а не O(N). Проход привязан к номеру шага,
+// а не к кадру, — досчёт линии времени повторяет его сам.
+
+const int CULL_INTERVAL = 8;  // шагов между проходами: кадр при стандартных подшагах
+
+struct CullRules {
+    bool enabled = true;
+    float maxDistance = 20000.0f;     // 0 — без предела
+    float unboundDistance = 2000.0f;  // 0 — не проверять энергию
+    bool absorb = true;               // падение в закреплённое тело
+    bool absorbMass = true;           // масса упавшего уходит поглотителю
+};
+
+struct CullState {
+    std::vector<int> doomed;  // индексы на удаление
+    std::vector<int> from;    // новый индекс -> старый после прохода
+    std::vector<int> fixedBodies;
+    int removed = 0;          // на последнем проходе
+    long long escaped = 0;
+    long long absorbed = 0;
+};
+
+// Один проход. true — тела убраны (индексы сдвинулись: см. cs.from).
+inline bool CullBodies(SlotMap<Body>& map, const CullRules& rules, CullState& cs) {
+    std::vector<Body>& bodies = map.dense;
+    size_t n = bodies.size();
+    cs.removed = 0;
+    cs.doomed.clear();
+    if (!rules.enabled || n < 2) return false;
+
+    // Центр масс и его скорость, в double
+    double mass = 0.0, x[3] = { 0.0, 0.0, 0.0 }, v[3] = { 0.0, 0.0, 0.0 };
+    cs.fixedBodies.clear();
+    for (size_t i = 0; i < n; i++) {
+        const Body& b = bodies[i];
+        double p[3];
+        BodyOffset(b, p);
+        mass += b.mass;
+        for (int c = 0; c < 3; c++) x[c] += b.mass*p[c];
+        v[0] += (double)b.mass*b.velocity.x;
+        v[1] += (double)b.mass*b.velocity.y;
+        v[2] += (double)b.mass*b.velocity.z;
+        if (b.isFixed) cs.fixedBodies.push_back((int)i);
+    }
+    if (mass <= 0.0) return false;
+    for (int c = 0; c < 3; c++) { x[c] /= mass; v[c] /= mass; }
+
+    double far2 = (double)rules.maxDistance*rules.maxDistance;
+    double unbound2 = (double)rules.unboundDistance*rules.unboundDistance;
+    for (size_t i = 0; i < n; i++) {
+        Body& b = bodies[i];
+        if (b.isFixed) continue;
+        double p[3];
+        BodyOffset(b, p);
+        double d[3] = { p[0] - x[0], p[1] - x[1], p[2] - x[2] };
+        double r2 = d[0]*d[0] + d[1]*d[1] + d[2]*d[2];
+
+        bool gone = rules.maxDistance > 0.0f && r2 > far2;
+        if (!gone && rules.unboundDistance > 0.0f && r2 > unbound2) {
+            double u[3] = { b.velocity.x - v[0], b.velocity.y - v[1], b.velocity.z - v[2] };
+            double outward = d[0]*u[0] + d[1]*u[1] + d[2]*u[2];
+            double energy = 0.5*(u[0]*u[0] + u[1]*u[1] + u[2]*u[2]) - G*mass/sqrt(r2);
+            gone = outward > 0.0 && energy > 0.0;
+        }
+        if (gone) {
+            cs.doomed.push_back((int)i);
+            cs.escaped++;
+            continue;
+        }
+
+        if (!rules.absorb) continue;
+        for (int f : cs.fixedBodies) {
+            Body& sink = bodies[f];
+            if (Vector3DistanceSqr(b.position, sink.position) >= sink.radius*sink.radius) continue;
+            if (rules.absorbMass) {
+                float total = sink.mass + b.mass;
+                sink.radius = MergedRadius(sink, total);
+                sink.mass = total;
+            }
+            cs.doomed.push_back((int)i);
+            cs.absorbed++;
+            break;
+        }
+    }
+    if (cs.doomed.empty()) return false;
+    cs.removed = (int)cs.doomed.size();
+    RemoveSlotsAt(map, cs.doomed, cs.from);
+    return true;
+}
+
+#endif
@@ -0,0 +1,452 @@
+#ifndef DIRECT_KERNEL_H
+#define DIRECT_KERNEL_H
+
+#include "gravity.h"
+#include "body_store.h"
+#include "thread_pool.h"
+#include "cache_info.h"
+#include "cpu_features.h"
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#if defined(GRAVITY_X86)
+    #include <immintrin.h>
+#endif
+#if defined(GRAVITY_NEON)
+    #include <arm_neon.h>
+#endif
+
+// --- ПРЯМАЯ СУММА ПО SoA ---
+// Одна цель против всех источников. Пара с нулевым расстоянием (само тело)
+// отбрасывается маской; хвост дополнения имеет нулевую массу.
+// Ядро считает сразу ускорение: a_i = G * sum(m_j * d * r^-3), где r^-1 —
+// одна аппаратная оценка rsqrt, уточнённая шагом Ньютона
+// y' = y*(1.5 - 0.5*x*y*y): вместо sqrt и деления на пару — только умножения.
+// Оценка rsqrtps (SSE/AVX) даёт 12 бит, шаг Ньютона доводит до ~22 бит;
+// rsqrt14 (AVX-512) — 14 бит; vrsqrte (NEON) — 8 бит, поэтому шага два.
+// Векторные варианты собраны все сразу (см. cpu_features.h), рабочий
+// выбирается по ActiveIsa().
+
+inline Vector3 DirectAccelerationScalar(const BodyStore& s, size_t i) {
+    float xi = s.x[i], yi = s.y[i], zi = s.z[i];
+    float ax = 0.0f, ay = 0.0f, az = 0.0f;
+    for (size_t j = 0; j < s.count; j++) {
+        float dx = s.x[j] - xi;
+        float dy = s.y[j] - yi;
+        float dz = s.z[j] - zi;
+        float distSq = dx*dx + dy*dy + dz*dz;
+        if (distSq <= 0.0f) continue;
+        float inv = 1.0f/sqrtf(distSq);
+        float scale = s.m[j]*inv*inv*inv;
+        ax += dx*scale; ay += dy*scale; az += dz*scale;
+    }
+    return { G*ax, G*ay, G*az };
+}
+
+// Заголовки AVX-512 в GCC 12 инициализируют _mm512_undefined_* самим собой,
+// и -Wall ругается на каждое встроенное ядро; предупреждение ложное.
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wuninitialized"
+    #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#if defined(GRAVITY_X86)
+GRAVITY_TARGET("sse2")
+inline float HorizontalSum128(__m128 v) {
+    __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+}
+
+GRAVITY_TARGET("sse2")
+inline __m128 RsqrtSse(__m128 x) {
+    __m128 y = _mm_rsqrt_ps(x);
+    __m128 yy = _mm_mul_ps(_mm_mul_ps(y, y), _mm_mul_ps(x, _mm_set1_ps(0.5f)));
+    return _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), yy));
+}
+
+GRAVITY_TARGET("sse2")
+inline Vector3 DirectAccelerationSse(const BodyStore& s, size_t i) {
+    __m128 xi = _mm_set1_ps(s.x[i]), yi = _mm_set1_ps(s.y[i]), zi = _mm_set1_ps(s.z[i]);
+    __m128 ax = _mm_setzero_ps(), ay = _mm_setzero_ps(), az = _mm_setzero_ps();
+    __m128 zero = _mm_setzero_ps();
+    for (size_t j = 0; j < s.padded; j += 4) {
+        __m128 dx = _mm_sub_ps(_mm_load_ps(&s.x[j]), xi);
+        __m128 dy = _mm_sub_ps(_mm_load_ps(&s.y[j]), yi);
+        __m128 dz = _mm_sub_ps(_mm_load_ps(&s.z[j]), zi);
+        __m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        __m128 mask = _mm_cmpgt_ps(distSq, zero);
+        __m128 inv = RsqrtSse(distSq);
+        __m128 scale = _mm_and_ps(_mm_mul_ps(_mm_load_ps(&s.m[j]), _mm_mul_ps(inv, _mm_mul_ps(inv, inv))), mask);
+        ax = _mm_add_ps(ax, _mm_mul_ps(dx, scale));
+        ay = _mm_add_ps(ay, _mm_mul_ps(dy, scale));
+        az = _mm_add_ps(az, _mm_mul_ps(dz, scale));
+    }
+    return { G*HorizontalSum128(ax), G*HorizontalSum128(ay), G*HorizontalSum128(az) };
+}
+
+GRAVITY_TARGET("avx2")
+inline float HorizontalSum256(__m256 v) {
+    return HorizontalSum128(_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+}
+
+GRAVITY_TARGET("avx2")
+inline __m256 RsqrtAvx2(__m256 x) {
+    __m256 y = _mm256_rsqrt_ps(x);
+    __m256 yy = _mm256_mul_ps(_mm256_mul_ps(y, y), _mm256_mul_ps(x, _mm256_set1_ps(0.5f)));
+    return _mm256_mul_ps(y, _mm256_sub_ps(_mm256_set1_ps(1.5f), yy));
+}
+
+GRAVITY_TARGET("avx2")
+inline Vector3 DirectAccelerationAvx2(const BodyStore& s, size_t i) {
+    __m256 xi = _mm256_set1_ps(s.x[i]), yi = _mm256_set1_ps(s.y[i]), zi = _mm256_set1_ps(s.z[i]);
+    __m256 ax = _mm256_setzero_ps(), ay = _mm256_setzero_ps(), az = _mm256_setzero_ps();
+    __m256 zero = _mm256_setzero_ps();
+    for (size_t j = 0; j < s.padded; j += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_load_ps(&s.x[j]), xi);
+        __m256 dy = _mm256_sub_ps(_mm256_load_ps(&s.y[j]), yi);
+        __m256 dz = _mm256_sub_ps(_mm256_load_ps(&s.z[j]), zi);
+        __m256 distSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+        __m256 mask = _mm256_cmp_ps(distSq, zero, _CMP_GT_OQ);
+        __m256 inv = RsqrtAvx2(distSq);
+        __m256 scale = _mm256_and_ps(_mm256_mul_ps(_mm256_load_ps(&s.m[j]), _mm256_mul_ps(inv, _mm256_mul_ps(inv, inv))), mask);
+        ax = _mm256_add_ps(ax, _mm256_mul_ps(dx, scale));
+        ay = _mm256_add_ps(ay, _mm256_mul_ps(dy, scale));
+        az = _mm256_add_ps(az, _mm256_mul_ps(dz, scale));
+    }
+    return { G*HorizontalSum256(ax), G*HorizontalSum256(ay), G*HorizontalSum256(az) };
+}
+
+// 16 дорожек сворачиваются через 256-битные половины: порядок сложения фиксирован
+GRAVITY_TARGET("avx512f")
+inline float HorizontalSum512(__m512 v) {
+    __m256 low = _mm512_castps512_ps256(v);
+    __m256 high = _mm512_castps512_ps256(_mm512_maskz_shuffle_f32x4(0xffff, v, v, _MM_SHUFFLE(3, 2, 3, 2)));
+    __m256 sum = _mm256_add_ps(low, high);
+    return HorizontalSum128(_mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1)));
+}
+
+GRAVITY_TARGET("avx512f")
+inline __m512 RsqrtAvx512(__m512 x) {
+    __m512 y = _mm512_rsqrt14_ps(x);
+    __m512 yy = _mm512_mul_ps(_mm512_mul_ps(y, y), _mm512_mul_ps(x, _mm512_set1_ps(0.5f)));
+    return _mm512_mul_ps(y, _mm512_sub_ps(_mm512_set1_ps(1.5f), yy));
+}
+
+GRAVITY_TARGET("avx512f")
+inline Vector3 DirectAccelerationAvx512(const BodyStore& s, size_t i) {
+    __m512 xi = _mm512_set1_ps(s.x[i]), yi = _mm512_set1_ps(s.y[i]), zi = _mm512_set1_ps(s.z[i]);
+    __m512 ax = _mm512_setzero_ps(), ay = _mm512_setzero_ps(), az = _mm512_setzero_ps();
+    __m512 zero = _mm512_setzero_ps();
+    for (size_t j = 0; j < s.padded; j += 16) {
+        __m512 dx = _mm512_sub_ps(_mm512_load_ps(&s.x[j]), xi);
+        __m512 dy = _mm512_sub_ps(_mm512_load_ps(&s.y[j]), yi);
+        __m512 dz = _mm512_sub_ps(_mm512_load_ps(&s.z[j]), zi);
+        __m512 distSq = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy)), _mm512_mul_ps(dz, dz));
+        __mmask16 mask = _mm512_cmp_ps_mask(distSq, zero, _CMP_GT_OQ);
+        __m512 inv = RsqrtAvx512(distSq);
+        __m512 scale = _mm512_maskz_mul_ps(mask, _mm512_load_ps(&s.m[j]), _mm512_mul_ps(inv, _mm512_mul_ps(inv, inv)));
+        ax = _mm512_add_ps(ax, _mm512_mul_ps(dx, scale));
+        ay = _mm512_add_ps(ay, _mm512_mul_ps(dy, scale));
+        az = _mm512_add_ps(az, _mm512_mul_ps(dz, scale));
+    }
+    return { G*HorizontalSum512(ax), G*HorizontalSum512(ay), G*HorizontalSum512(az) };
+}
+#endif
+
+#if defined(GRAVITY_NEON)
+inline float HorizontalSumNeon(float32x4_t v) {
+    float32x2_t pair = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(pair, pair), 0);
+}
+
+// vrsqrts(a, b) = (3 - a*b)/2 — готовый множитель шага Ньютона
+inline float32x4_t RsqrtNeon(float32x4_t x) {
+    float32x4_t y = vrsqrteq_f32(x);
+    y = vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(x, y), y));
+    return vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(x, y), y));
+}
+
+inline Vector3 DirectAccelerationNeon(const BodyStore& s, size_t i) {
+    float32x4_t xi = vdupq_n_f32(s.x[i]), yi = vdupq_n_f32(s.y[i]), zi = vdupq_n_f32(s.z[i]);
+    float32x4_t ax = vdupq_n_f32(0.0f), ay = vdupq_n_f32(0.0f), az = vdupq_n_f32(0.0f);
+    float32x4_t zero = vdupq_n_f32(0.0f);
+    for (size_t j = 0; j < s.padded; j += 4) {
+        float32x4_t dx = vsubq_f32(vld1q_f32(&s.x[j]), xi);
+        float32x4_t dy = vsubq_f32(vld1q_f32(&s.y[j]), yi);
+        float32x4_t dz = vsubq_f32(vld1q_f32(&s.z[j]), zi);
+        float32x4_t distSq = vaddq_f32(vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy)), vmulq_f32(dz, dz));
+        uint32x4_t mask = vcgtq_f32(distSq, zero);
+        float32x4_t inv = RsqrtNeon(distSq);
+        float32x4_t scale = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(vmulq_f32(vld1q_f32(&s.m[j]), vmulq_f32(inv, vmulq_f32(inv, inv)))), mask));
+        ax = vaddq_f32(ax, vmulq_f32(dx, scale));
+        ay = vaddq_f32(ay, vmulq_f32(dy, scale));
+        az = vaddq_f32(az, vmulq_f32(dz, scale));
+    }
+    return { G*HorizontalSumNeon(ax), G*HorizontalSumNeon(ay), G*HorizontalSumNeon(az) };
+}
+#endif
+
+// Ядро выбранного набора команд
+inline Vector3 DirectAcceleration(const BodyStore& s, size_t i) {
+    switch (ActiveIsa()) {
+#if defined(GRAVITY_X86)
+        case ISA_AVX512: return DirectAccelerationAvx512(s, i);
+        case ISA_AVX2: return DirectAccelerationAvx2(s, i);
+        case ISA_SSE2: return DirectAccelerationSse(s, i);
+#endif
+#if defined(GRAVITY_NEON)
+        case ISA_NEON: return DirectAccelerationNeon(s, i);
+#endif
+        default: return DirectAccelerationScalar(s, i);
+    }
+}
+
+inline const char* DirectKernelName() {
+    return IsaName(ActiveIsa());
+}
+
+// Построчный вариант: каждая цель проходит по всем источникам.
+// Решатель по умолчанию: блочный пока не выиграл по времени ни на одной
+// измеренной машине (см. BenchDirectTiling).
+inline void ComputeAccelerationsDirectUntiled(const std::vector<Body>& bodies, std::vector<Vector3>& acc, BodyStore& store, ThreadPool* pool) {
+    PackBodies(bodies, store);
+    acc.assign(bodies.size(), {0,0,0});
+    ParallelFor(pool, store.count, 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if (store.fixed[i]) continue;
+            acc[i] = DirectAcceleration(store, i);
+        }
+    });
+}
+
+// --- БЛОЧНАЯ ПРЯМАЯ СУММА ---
+// Плитка источников держится в L1, пока по ней проходит блок целей; векторные
+// суммы целей живут в маленьком буфере между плитками. Каждая дорожка вектора
+// складывает те же источники в том же порядке, что и построчный вариант,
+// поэтому результат совпадает с ним побитово.
+
+struct DirectTiling {
+    size_t targets;  // целей в блоке
+    size_t sources;  // источников в плитке (кратно BODY_STORE_WIDTH)
+};
+
+// Суммы блоков целей: по участку targets*lanes на кусок ParallelFor
+struct DirectBuffers {
+    AlignedFloats sx, sy, sz;
+};
+
+// Плитка источников (x, y, z, m — 16 байт на тело) занимает половину L1,
+// суммы блока целей (3 вектора на цель) — четверть L1.
+inline DirectTiling ChooseDirectTiling(const CacheSizes& cache) {
+    size_t sources = (cache.l1d/2)/(4*sizeof(float));
+    sources = sources/BODY_STORE_WIDTH*BODY_STORE_WIDTH;
+    if (sources < 256) sources = 256;
+    if (sources > 8192) sources = 8192;
+    size_t targets = (cache.l1d/4)/(3*BODY_STORE_WIDTH*sizeof(float));
+    targets = targets/16*16;
+    if (targets < 16) targets = 16;
+    if (targets > 256) targets = 256;
+    return { targets, sources };
+}
+
+inline void DirectBlockScalar(const BodyStore& s, size_t i0, size_t i1, size_t j0, size_t j1, float* sx, float* sy, float* sz) {
+    if (j1 > s.count) j1 = s.count;
+    for (size_t i = i0; i < i1; i++) {
+        float xi = s.x[i], yi = s.y[i], zi = s.z[i];
+        float ax = sx[i - i0], ay = sy[i - i0], az = sz[i - i0];
+        for (size_t j = j0; j < j1; j++) {
+            float dx = s.x[j] - xi;
+            float dy = s.y[j] - yi;
+            float dz = s.z[j] - zi;
+            float distSq = dx*dx + dy*dy + dz*dz;
+            if (distSq <= 0.0f) continue;
+            float inv = 1.0f/sqrtf(distSq);
+            float scale = s.m[j]*inv*inv*inv;
+            ax += dx*scale; ay += dy*scale; az += dz*scale;
+        }
+        sx[i - i0] = ax; sy[i - i0] = ay; sz[i - i0] = az;
+    }
+}
+
+#if defined(GRAVITY_X86)
+GRAVITY_TARGET("sse2")
+inline void DirectBlockSse(const BodyStore& s, size_t i0, size_t i1, size_t j0, size_t j1, float* sx, float* sy, float* sz) {
+    __m128 zero = _mm_setzero_ps();
+    for (size_t i = i0; i < i1; i++) {
+        __m128 xi = _mm_set1_ps(s.x[i]), yi = _mm_set1_ps(s.y[i]), zi = _mm_set1_ps(s.z[i]);
+        size_t slot = (i - i0)*4;
+        __m128 ax = _mm_load_ps(&sx[slot]), ay = _mm_load_ps(&sy[slot]), az = _mm_load_ps(&sz[slot]);
+        for (size_t j = j0; j < j1; j += 4) {
+            __m128 dx = _mm_sub_ps(_mm_load_ps(&s.x[j]), xi);
+            __m128 dy = _mm_sub_ps(_mm_load_ps(&s.y[j]), yi);
+            __m128 dz = _mm_sub_ps(_mm_load_ps(&s.z[j]), zi);
+            __m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            __m128 mask = _mm_cmpgt_ps(distSq, zero);
+            __m128 inv = RsqrtSse(distSq);
+            __m128 scale = _mm_and_ps(_mm_mul_ps(_mm_load_ps(&s.m[j]), _mm_mul_ps(inv, _mm_mul_ps(inv, inv))), mask);
+            ax = _mm_add_ps(ax, _mm_mul_ps(dx, scale));
+            ay = _mm_add_ps(ay, _mm_mul_ps(dy, scale));
+            az = _mm_add_ps(az, _mm_mul_ps(dz, scale));
+        }
+        _mm_store_ps(&sx[slot], ax); _mm_store_ps(&sy[slot], ay); _mm_store_ps(&sz[slot], az);
+    }
+}
+
+GRAVITY_TARGET("avx2")
+inline void DirectBlockAvx2(const BodyStore& s, size_t i0, size_t i1, size_t j0, size_t j1, float* sx, float* sy, float* sz) {
+    __m256 zero = _mm256_setzero_ps();
+    for (size_t i = i0; i < i1; i++) {
+        __m256 xi = _mm256_set1_ps(s.x[i]), yi = _mm256_set1_ps(s.y[i]), zi = _mm256_set1_ps(s.z[i]);
+        size_t slot = (i - i0)*8;
+        __m256 ax = _mm256_load_ps(&sx[slot]), ay = _mm256_load_ps(&sy[slot]), az = _mm256_load_ps(&sz[slot]);
+        for (size_t j = j0; j < j1; j += 8) {
+            __m256 dx = _mm256_sub_ps(_mm256_load_ps(&s.x[j]), xi);
+            __m256 dy = _mm256_sub_ps(_mm256_load_ps(&s.y[j]), yi);
+            __m256 dz = _mm256_sub_ps(_mm256_load_ps(&s.z[j]), zi);
+            __m256 distSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+            __m256 mask = _mm256_cmp_ps(distSq, zero, _CMP_GT_OQ);
+            __m256 inv = RsqrtAvx2(distSq);
+            __m256 scale = _mm256_and_ps(_mm256_mul_ps(_mm256_load_ps(&s.m[j]), _mm256_mul_ps(inv, _mm256_mul_ps(inv, inv))), mask);
+            ax = _mm256_add_ps(ax, _mm256_mul_ps(dx, scale));
+            ay = _mm256_add_ps(ay, _mm256_mul_ps(dy, scale));
+            az = _mm256_add_ps(az, _mm256_mul_ps(dz, scale));
+        }
+        _mm256_store_ps(&sx[slot], ax); _mm256_store_ps(&sy[slot], ay); _mm256_store_ps(&sz[slot], az);
+    }
+}
+
+GRAVITY_TARGET("avx512f")
+inline void DirectBlockAvx512(const BodyStore& s, size_t i0, size_t i1, size_t j0, size_t j1, float* sx, float* sy, float* sz) {
+    __m512 zero = _mm512_setzero_ps();
+    for (size_t i = i0; i < i1; i++) {
+        __m512 xi = _mm512_set1_ps(s.x[i]), yi = _mm512_set1_ps(s.y[i]), zi = _mm512_set1_ps(s.z[i]);
+        size_t slot = (i - i0)*16;
+        __m512 ax = _mm512_load_ps(&sx[slot]), ay = _mm512_load_ps(&sy[slot]), az = _mm512_load_ps(&sz[slot]);
+        for (size_t j = j0; j < j1; j += 16) {
+            __m512 dx = _mm512_sub_ps(_mm512_load_ps(&s.x[j]), xi);
+            __m512 dy = _mm512_sub_ps(_mm512_load_ps(&s.y[j]), yi);
+            __m512 dz = _mm512_sub_ps(_mm512_load_ps(&s.z[j]), zi);
+            __m512 distSq = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy)), _mm512_mul_ps(dz, dz));
+            __mmask16 mask = _mm512_cmp_ps_mask(distSq, zero, _CMP_GT_OQ);
+            __m512 inv = RsqrtAvx512(distSq);
+            __m512 scale = _mm512_maskz_mul_ps(mask, _mm512_load_ps(&s.m[j]), _mm512_mul_ps(inv, _mm512_mul_ps(inv, inv)));
+            ax = _mm512_add_ps(ax, _mm512_mul_ps(dx, scale));
+            ay = _mm512_add_ps(ay, _mm512_mul_ps(dy, scale));
+            az = _mm512_add_ps(az, _mm512_mul_ps(dz, scale));
+        }
+        _mm512_store_ps(&sx[slot], ax); _mm512_store_ps(&sy[slot], ay); _mm512_store_ps(&sz[slot], az);
+    }
+}
+#endif
+
+#if defined(GRAVITY_NEON)
+inline void DirectBlockNeon(const BodyStore& s, size_t i0, size_t i1, size_t j0, size_t j1, float* sx, float* sy, float* sz) {
+    float32x4_t zero = vdupq_n_f32(0.0f);
+    for (size_t i = i0; i < i1; i++) {
+        float32x4_t xi = vdupq_n_f32(s.x[i]), yi = vdupq_n_f32(s.y[i]), zi = vdupq_n_f32(s.z[i]);
+        size_t slot = (i - i0)*4;
+        float32x4_t ax = vld1q_f32(&sx[slot]), ay = vld1q_f32(&sy[slot]), az = vld1q_f32(&sz[slot]);
+        for (size_t j = j0; j < j1; j += 4) {
+            float32x4_t dx = vsubq_f32(vld1q_f32(&s.x[j]), xi);
+            float32x4_t dy = vsubq_f32(vld1q_f32(&s.y[j]), yi);
+            float32x4_t dz = vsubq_f32(vld1q_f32(&s.z[j]), zi);
+            float32x4_t distSq = vaddq_f32(vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy)), vmulq_f32(dz, dz));
+            uint32x4_t mask = vcgtq_f32(distSq, zero);
+            float32x4_t inv = RsqrtNeon(distSq);
+            float32x4_t scale = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(vmulq_f32(vld1q_f32(&s.m[j]), vmulq_f32(inv, vmulq_f32(inv, inv)))), mask));
+            ax = vaddq_f32(ax, vmulq_f32(dx, scale));
+            ay = vaddq_f32(ay, vmulq_f32(dy, scale));
+            az = vaddq_f32(az, vmulq_f32(dz, scale));
+        }
+        vst1q_f32(&sx[slot], ax); vst1q_f32(&sy[slot], ay); vst1q_f32(&sz[slot], az);
+    }
+}
+#endif
+
+inline void DirectBlock(GravityIsa isa, const BodyStore& s, size_t i0, size_t i1, size_t j0, size_t j1, float* sx, float* sy, float* sz) {
+    switch (isa) {
+#if defined(GRAVITY_X86)
+        case ISA_AVX512: DirectBlockAvx512(s, i0, i1, j0, j1, sx, sy, sz); break;
+        case ISA_AVX2: DirectBlockAvx2(s, i0, i1, j0, j1, sx, sy, sz); break;
+        case ISA_SSE2: DirectBlockSse(s, i0, i1, j0, j1, sx, sy, sz); break;
+#endif
+#if defined(GRAVITY_NEON)
+        case ISA_NEON: DirectBlockNeon(s, i0, i1, j0, j1, sx, sy, sz); break;
+#endif
+        default: DirectBlockScalar(s, i0, i1, j0, j1, sx, sy, sz); break;
+    }
+}
+
+// Свёртка дорожек тем же способом, что и в построчных ядрах. Векторы не
+// передаются через границу функций с разным target: грузим по указателю.
+#if defined(GRAVITY_X86)
+GRAVITY_TARGET("sse2")
+inline float LaneSumSse(const float* lanes) { return HorizontalSum128(_mm_load_ps(lanes)); }
+GRAVITY_TARGET("avx2")
+inline float LaneSumAvx2(const float* lanes) { return HorizontalSum256(_mm256_load_ps(lanes)); }
+GRAVITY_TARGET("avx512f")
+inline float LaneSumAvx512(const float* lanes) { return HorizontalSum512(_mm512_load_ps(lanes)); }
+#endif
+
+inline float DirectLaneSum(GravityIsa isa, const float* lanes) {
+    switch (isa) {
+#if defined(GRAVITY_X86)
+        case ISA_AVX512: return LaneSumAvx512(lanes);
+        case ISA_AVX2: return LaneSumAvx2(lanes);
+        case ISA_SSE2: return LaneSumSse(lanes);
+#endif
+#if defined(GRAVITY_NEON)
+        case ISA_NEON: return HorizontalSumNeon(vld1q_f32(lanes));
+#endif
+        default: return lanes[0];
+    }
+}
+
+inline void ComputeAccelerationsDirect(const std::vector<Body>& bodies, std::vector<Vector3>& acc, BodyStore& store, const DirectTiling& tiling, DirectBuffers& buf, ThreadPool* pool) {
+    PackBodies(bodies, store);
+    acc.assign(bodies.size(), {0,0,0});
+    GravityIsa isa = ActiveIsa();
+    size_t lanes = (size_t)IsaLanes(isa);
+    size_t blocks = (store.count + tiling.targets - 1)/tiling.targets;
+    // Несколько кусков на поток для балансировки; у каждого куска свой участок сумм
+    size_t chunk = (blocks + 4*ThreadPoolSize(pool) - 1)/(4*ThreadPoolSize(pool));
+    if (chunk == 0) chunk = 1;
+    size_t slots = (blocks + chunk - 1)/chunk;
+    size_t span = tiling.targets*lanes;
+    if (buf.sx.size() < slots*span) {
+        buf.sx.resize(slots*span);
+        buf.sy.resize(slots*span);
+        buf.sz.resize(slots*span);
+    }
+    ParallelFor(pool, blocks, chunk, [&](size_t begin, size_t end) {
+        float* sx = buf.sx.data() + (begin/chunk)*span;
+        float* sy = buf.sy.data() + (begin/chunk)*span;
+        float* sz = buf.sz.data() + (begin/chunk)*span;
+        for (size_t block = begin; block < end; block++) {
+            size_t i0 = block*tiling.targets;
+            size_t i1 = (i0 + tiling.targets < store.count) ? i0 + tiling.targets : store.count;
+            std::fill(sx, sx + span, 0.0f);
+            std::fill(sy, sy + span, 0.0f);
+            std::fill(sz, sz + span, 0.0f);
+            for (size_t j0 = 0; j0 < store.padded; j0 += tiling.sources) {
+                size_t j1 = (j0 + tiling.sources < store.padded) ? j0 + tiling.sources : store.padded;
+                DirectBlock(isa, store, i0, i1, j0, j1, sx, sy, sz);
+            }
+            for (size_t i = i0; i < i1; i++) {
+                if (store.fixed[i]) continue;
+                size_t slot = (i - i0)*lanes;
+                acc[i] = { G*DirectLaneSum(isa, &sx[slot]), G*DirectLaneSum(isa, &sy[slot]), G*DirectLaneSum(isa, &sz[slot]) };
+            }
+        }
+    });
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic pop
+#endif
+
+#endif
@@ -0,0 +1,282 @@
+#ifndef ENCOUNTERS_H
+#define ENCOUNTERS_H
+
+#include "gravity.h"
+#include "floating_origin.h"
+#include "kepler.h"
+#include "spatial_hash.h"
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+// --- ТЕСНЫЕ ПАРЫ ---
+// Сила без смягчения: при сближении ускорение растёт как 1/r^2, и общий шаг
+// пришлось бы мельчить ради одной пары. Пара, чьё собственное время короче
+// ENCOUNTER_STEPS шагов и которую третьи тела почти не раскачивают, выделяется
+// в подсистему. Её относительное движение переносится точно по Кеплеру в
+// универсальных переменных (регуляризованная форма: нет деления на r, проход
+// через перицентр не требует мелкого шага). Для остальных тел пара — одна
+// точка в центре масс; ускорение этой точки получают оба члена пары.
+// Приливы от третьих тел в переносе не учитываются, поэтому нужна изоляция:
+// тело массы m_k на расстоянии R от центра пары тянет её члены врозь
+// ускорением ~2 G m_k d / R^3 против связи G m / d^2. Сумма отношений по
+// третьим телам не должна превышать ENCOUNTER_TIDE — пара внутри своей
+// сферы Хилла с запасом.
+
+const float ENCOUNTER_STEPS = 10.0f;       // собственное время пары в шагах
+const float ENCOUNTER_TIDE = 1.0f/64.0f;  // предел приливов к связи; равная масса — не ближе 4d
+
+struct EncounterPair {
+    int a, b;
+    bool operator==(const EncounterPair& o) const { return a == o.a && b == o.b; }
+};
+
+struct EncounterState {
+    std::vector<EncounterPair> pairs;     // по возрастанию a
+    std::vector<EncounterPair> previous;  // пары прошлого шага
+    std::vector<int> partner;      // индекс пары тела или -1
+    std::vector<Body> reduced;     // одиночные тела и центры масс пар
+    std::vector<int> reducedIndex; // тело -> индекс в reduced
+    std::vector<Vector3> reducedAcc;
+    SpatialHash grid;
+    std::vector<int> nearest;
+    std::vector<float> nearestDist;
+    std::vector<int> touched;      // тело -> номер последней поправки (RepairEncounterAccelerations)
+    int repairs = 0;
+    float maxMass = 0.0f;          // тяжелейшее подвижное тело на последнем поиске
+};
+
+// Радиус, дальше которого тело сетки пару массы mass на расстоянии d не
+// раскачивает (сфера Хилла против самого тяжёлого тела)
+inline float EncounterHillRadius(const EncounterState& es, float d, float mass) {
+    return d*cbrtf(2.0f*es.maxMass/(ENCOUNTER_TIDE*mass));
+}
+
+// Пары на шаг dt; true — набор пар изменился (кэш ускорений устарел)
+inline bool FindEncounterPairs(const std::vector<Body>& bodies, float dt, EncounterState& es) {
+    size_t n = bodies.size();
+    float maxMass = 0.0f;
+    for (const Body& b : bodies) if (!b.isFixed) maxMass = fmaxf(maxMass, b.mass);
+    es.maxMass = maxMass;
+    // Самая дальняя пара, которую ещё стоит выделять: sqrt(r^3/(G*M)) = ENCOUNTER_STEPS*dt
+    float reach = cbrtf(G*2.0f*maxMass*(ENCOUNTER_STEPS*dt)*(ENCOUNTER_STEPS*dt));
+    // Ячейка — два reach: ближайший ищется не дальше чем в 8 ячейках. Тело
+    // сетки не тяжелее maxMass, и раскачать пару оно может только ближе
+    // d*cbrt(2*maxMass/(ENCOUNTER_TIDE*m)) — для d на пределе это
+    // reach*cbrt(1/ENCOUNTER_TIDE), не больше 5 ячеек по оси.
+    float cell = fmaxf(2.0f*reach, 1e-3f);
+
+    // Закреплённые и крупнее ячейки пару не образуют (расстояние меньше
+    // reach значит касание), а в сетке их пришлось бы искать в кубе по радиусу
+    BuildSpatialHash(es.grid, bodies, cell, [&](int i) { return bodies[i].isFixed || bodies[i].radius > cell; });
+
+    // Ближайший подвижный сосед каждого подвижного тела
+    es.nearest.assign(n, -1);
+    es.nearestDist.assign(n, 0.0f);
+    for (size_t i = 0; i < n; i++) {
+        if (bodies[i].isFixed || bodies[i].radius > cell) continue;
+        float best = reach*reach;
+        ForEachNearInSpatialHash(es.grid, bodies[i].position, reach, [&](int j) {
+            if (j == (int)i) return;
+            float d2 = Vector3DistanceSqr(bodies[i].position, bodies[j].position);
+            if (d2 < best) { best = d2; es.nearest[i] = j; }
+        });
+        es.nearestDist[i] = sqrtf(best);
+    }
+
+    std::vector<EncounterPair> pairs;
+    for (size_t i = 0; i < n; i++) {
+        int j = es.nearest[i];
+        if (j <= (int)i || es.nearest[j] != (int)i) continue;  // только взаимные, каждую пару раз
+        float d = es.nearestDist[i];
+        float mass = bodies[i].mass + bodies[j].mass;
+        if (d*d*d > G*mass*(ENCOUNTER_STEPS*dt)*(ENCOUNTER_STEPS*dt)) continue;
+        // Изоляция: сумма 2 m_k / R^3 третьих тел против ENCOUNTER_TIDE*m/d^3.
+        // Сетку — в сфере Хилла пары против самого тяжёлого тела, закреплённые
+        // и крупные (звезда — главный источник приливов) — все.
+        Vector3 mid = Vector3Lerp(bodies[i].position, bodies[j].position, 0.5f);
+        float limit = ENCOUNTER_TIDE*mass/(d*d*d);
+        float tide = 0.0f;
+        auto perturb = [&](int k) {
+            if (k == (int)i || k == j) return;
+            float r2 = Vector3DistanceSqr(mid, bodies[k].position);
+            tide += (r2 > 0.0f) ? 2.0f*bodies[k].mass/(r2*sqrtf(r2)) : INFINITY;
+        };
+        ForEachNearInSpatialHash(es.grid, mid, EncounterHillRadius(es, d, mass), perturb);
+        for (int k : es.grid.large) perturb(k);
+        if (tide < limit) pairs.push_back({ (int)i, j });
+    }
+
+    bool changed = pairs != es.pairs || es.partner.size() != n;
+    es.previous.swap(es.pairs);
+    es.pairs.swap(pairs);
+    es.partner.assign(n, -1);
+    for (size_t p = 0; p < es.pairs.size(); p++) {
+        es.partner[es.pairs[p].a] = (int)p;
+        es.partner[es.pairs[p].b] = (int)p;
+    }
+    return changed;
+}
+
+// Центр масс пары в double: положение и скорость
+inline void PairCenter(const Body& a, const Body& b, double c[3], double v[3]) {
+    double pa[3], pb[3];
+    BodyOffset(a, pa);
+    BodyOffset(b, pb);
+    double m = (double)a.mass + b.mass;
+    double va[3] = { a.velocity.x, a.velocity.y, a.velocity.z };
+    double vb[3] = { b.velocity.x, b.velocity.y, b.velocity.z };
+    for (int k = 0; k < 3; k++) {
+        c[k] = (a.mass*pa[k] + b.mass*pb[k])/m;
+        v[k] = (a.mass*va[k] + b.mass*vb[k])/m;
+    }
+}
+
+inline bool HasEncounterPair(const std::vector<EncounterPair>& pairs, EncounterPair p) {
+    auto it = std::lower_bound(pairs.begin(), pairs.end(), p, [](const EncounterPair& x, const EncounterPair& y) { return x.a < y.a; });
+    return it != pairs.end() && *it == p;
+}
+
+// G*m*(to - from)/|to - from|^3 в double
+inline void PointPull(const double* from, const double* to, double m, double* out) {
+    double r[3] = { to[0] - from[0], to[1] - from[1], to[2] - from[2] };
+    double r2 = r[0]*r[0] + r[1]*r[1] + r[2]*r[2];
+    double s = (r2 > 0.0) ? (double)G*m/(r2*sqrt(r2)) : 0.0;
+    for (int k = 0; k < 3; k++) out[k] = r[k]*s;
+}
+
+// Пара p для тел вокруг стала двумя телами (sign = 1) или точкой в центре
+// масс (sign = -1): разница притяжений в сфере Хилла пары. Распавшейся паре
+// ещё и приливы от тех же тел: её члены несли ускорение центра, а пару
+// разбил как раз близкий сосед. Дальше разница — квадруполь пары и слабые
+// приливы, их кэш и так не видит.
+inline void RepairAroundPair(const std::vector<Body>& bodies, EncounterState& es, EncounterPair p, double sign, std::vector<Vector3>& acc) {
+    const Body& a = bodies[p.a];
+    const Body& b = bodies[p.b];
+    double pa[3], pb[3], c[3], v[3];
+    BodyOffset(a, pa);
+    BodyOffset(b, pb);
+    PairCenter(a, b, c, v);
+    double m = (double)a.mass + b.mass;
+    float d = Vector3Distance(a.position, b.position);
+    Vector3 mid = Vector3Lerp(a.position, b.position, 0.5f);
+    int stamp = ++es.repairs;  // корзина может попасться дважды — тело правится раз
+    auto fix = [&](int k) {
+        if (k == p.a || k == p.b || es.touched[k] == stamp) return;
+        es.touched[k] = stamp;
+        double x[3], fa[3], fb[3], fc[3];
+        BodyOffset(bodies[k], x);
+        if (sign > 0.0) {
+            PointPull(c, x, bodies[k].mass, fc);
+            PointPull(pa, x, bodies[k].mass, fa);
+            PointPull(pb, x, bodies[k].mass, fb);
+            acc[p.a] = Vector3Add(acc[p.a], { (float)(fa[0] - fc[0]), (float)(fa[1] - fc[1]), (float)(fa[2] - fc[2]) });
+            acc[p.b] = Vector3Add(acc[p.b], { (float)(fb[0] - fc[0]), (float)(fb[1] - fc[1]), (float)(fb[2] - fc[2]) });
+        }
+        if (bodies[k].isFixed) return;
+        PointPull(x, pa, a.mass, fa);
+        PointPull(x, pb, b.mass, fb);
+        PointPull(x, c, m, fc);
+        acc[k].x += (float)(sign*(fa[0] + fb[0] - fc[0]));
+        acc[k].y += (float)(sign*(fa[1] + fb[1] - fc[1]));
+        acc[k].z += (float)(sign*(fa[2] + fb[2] - fc[2]));
+    };
+    ForEachNearInSpatialHash(es.grid, mid, fminf(EncounterHillRadius(es, d, (float)m), 2.0f*es.grid.cell), fix);
+    for (int k : es.grid.large) fix(k);
+}
+
+// Набор пар сменился, тела те же (позиции конца прошлого шага): кэш
+// ускорений leapfrog поправляется, а не считается заново. Распавшейся паре
+// возвращается взаимное притяжение, соседям в её сфере Хилла — два тела
+// вместо точки (и наоборот у новой пары). Каждая пара затем получает
+// ускорение центра масс — среднее ускорений членов с весами масс, взаимные
+// члены в нём сокращаются. Внешнее поле на члена и на центр считается
+// одним — то же приближение, что у самих пар. false — кэш не от этих тел,
+// нужен полный пересчёт.
+inline bool RepairEncounterAccelerations(const std::vector<Body>& bodies, EncounterState& es, std::vector<Vector3>& acc) {
+    size_t n = bodies.size();
+    if (acc.size() != n || es.partner.size() != n) return false;
+    for (const EncounterPair& p : es.previous) {
+        if (p.a >= (int)n || p.b >= (int)n) return false;
+    }
+    es.touched.assign(n, 0);
+    es.repairs = 0;
+    for (const EncounterPair& p : es.previous) {
+        if (HasEncounterPair(es.pairs, p)) continue;
+        double pa[3], pb[3], f[3];
+        BodyOffset(bodies[p.a], pa);
+        BodyOffset(bodies[p.b], pb);
+        PointPull(pa, pb, 1.0, f);
+        Vector3 pull = { (float)f[0], (float)f[1], (float)f[2] };
+        acc[p.a] = Vector3Add(acc[p.a], Vector3Scale(pull, bodies[p.b].mass));
+        acc[p.b] = Vector3Subtract(acc[p.b], Vector3Scale(pull, bodies[p.a].mass));
+        RepairAroundPair(bodies, es, p, 1.0, acc);
+    }
+    for (const EncounterPair& p : es.pairs) {
+        if (!HasEncounterPair(es.previous, p)) RepairAroundPair(bodies, es, p, -1.0, acc);
+    }
+    for (const EncounterPair& p : es.pairs) {
+        float ma = bodies[p.a].mass, mb = bodies[p.b].mass;
+        Vector3 center = Vector3Scale(Vector3Add(Vector3Scale(acc[p.a], ma), Vector3Scale(acc[p.b], mb)), 1.0f/(ma + mb));
+        acc[p.a] = acc[p.b] = center;
+    }
+    return true;
+}
+
+// Список для решателя: пары заменены центрами масс
+inline const std::vector<Body>& ReduceEncounterPairs(const std::vector<Body>& bodies, EncounterState& es) {
+    es.reduced.clear();
+    es.reducedIndex.assign(bodies.size(), -1);
+    for (size_t i = 0; i < bodies.size(); i++) {
+        if (es.partner[i] >= 0) continue;
+        es.reducedIndex[i] = (int)es.reduced.size();
+        es.reduced.push_back(bodies[i]);
+    }
+    for (const EncounterPair& p : es.pairs) {
+        const Body& a = bodies[p.a];
+        const Body& b = bodies[p.b];
+        Body center = a;
+        double c[3], v[3];
+        PairCenter(a, b, c, v);
+        SetBodyOffset(center, c[0], c[1], c[2]);
+        center.velocity = { (float)v[0], (float)v[1], (float)v[2] };
+        center.mass = a.mass + b.mass;
+        center.radius = fmaxf(a.radius, b.radius);
+        es.reducedIndex[p.a] = es.reducedIndex[p.b] = (int)es.reduced.size();
+        es.reduced.push_back(center);
+    }
+    return es.reduced;
+}
+
+// Ускорения reduced обратно по телам: оба члена пары получают ускорение центра
+inline void ExpandEncounterAccelerations(const EncounterState& es, std::vector<Vector3>& acc) {
+    acc.resize(es.reducedIndex.size());
+    for (size_t i = 0; i < acc.size(); i++) acc[i] = es.reducedAcc[es.reducedIndex[i]];
+}
+
+// Перенос пары за dt: центр масс прямолинейно, относительное движение — по Кеплеру
+inline void DriftEncounterPair(Body& a, Body& b, double dt) {
+    double c[3], vc[3], pa[3], pb[3];
+    PairCenter(a, b, c, vc);
+    BodyOffset(a, pa);
+    BodyOffset(b, pb);
+    double r[3], v[3];
+    for (int k = 0; k < 3; k++) r[k] = pb[k] - pa[k];
+    v[0] = (double)b.velocity.x - a.velocity.x;
+    v[1] = (double)b.velocity.y - a.velocity.y;
+    v[2] = (double)b.velocity.z - a.velocity.z;
+    double m = (double)a.mass + b.mass;
+    if (!KeplerDrift((double)G*m, r, v, dt)) {
+        DriftBody(a, (float)dt);  // не сошлось (тела совпали) — как раньше, по прямой
+        DriftBody(b, (float)dt);
+        return;
+    }
+    double fa = b.mass/m, fb = a.mass/m;
+    for (int k = 0; k < 3; k++) c[k] += vc[k]*dt;
+    SetBodyOffset(a, c[0] - fa*r[0], c[1] - fa*r[1], c[2] - fa*r[2]);
+    SetBodyOffset(b, c[0] + fb*r[0], c[1] + fb*r[1], c[2] + fb*r[2]);
+    a.velocity = { (float)(vc[0] - fa*v[0]), (float)(vc[1] - fa*v[1]), (float)(vc[2] - fa*v[2]) };
+    b.velocity = { (float)(vc[0] + fb*v[0]), (float)(vc[1] + fb*v[1]), (float)(vc[2] + fb*v[2]) };
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef FLOATING_ORIGIN_H
+#define FLOATING_ORIGIN_H
+
+#include "gravity.h"
+#include <vector>
+#include <cmath>
+
+// --- ПЛАВАЮЩЕЕ НАЧАЛО КООРДИНАТ ---
+// Мировая позиция тела = origin (double) + position (float) + positionLo (float).
+// Пара position/positionLo — double-float: смещение за шаг копится с
+// компенсацией, поэтому мелкие шаги не теряются вдали от начала координат.
+// Когда камера уходит далеко, начало переносится к ней (с шагом сетки,
+// чтобы сетка не дёргалась), и float-координаты снова малы.
+
+struct WorldOrigin {
+    double x, y, z;
+};
+
+const float REBASE_DISTANCE = 2000.0f;  // перенос, когда цель камеры дальше этого
+
+// hi + lo += delta без потери младших битов (сумма Кэхэна)
+inline void AddCompensated(float& hi, float& lo, float delta) {
+    float y = delta + lo;
+    float t = hi + y;
+    lo = y - (t - hi);
+    hi = t;
+}
+
+inline void DriftBody(Body& b, float dt) {
+    AddCompensated(b.position.x, b.positionLo.x, b.velocity.x*dt);
+    AddCompensated(b.position.y, b.positionLo.y, b.velocity.y*dt);
+    AddCompensated(b.position.z, b.positionLo.z, b.velocity.z*dt);
+}
+
+// Точная позиция относительно начала координат
+inline void BodyOffset(const Body& b, double out[3]) {
+    out[0] = (double)b.position.x + b.positionLo.x;
+    out[1] = (double)b.position.y + b.positionLo.y;
+    out[2] = (double)b.position.z + b.positionLo.z;
+}
+
+// value = hi + lo. volatile не даёт оптимизатору свернуть (double)(float)v в v:
+// GCC 12 при -O2 делает так в векторизованном коде, и lo становится нулём.
+inline void SplitDouble(double value, float* hi, float* lo) {
+    volatile float rounded = (float)value;
+    *hi = rounded;
+    *lo = (float)(value - (double)*hi);
+}
+
+inline void SetBodyOffset(Body& b, double x, double y, double z) {
+    SplitDouble(x, &b.position.x, &b.positionLo.x);
+    SplitDouble(y, &b.position.y, &b.positionLo.y);
+    SplitDouble(z, &b.position.z, &b.positionLo.z);
+}
+
+inline float SnapToSpacing(float value, float spacing) {
+    return roundf(value/spacing)*spacing;
+}
+
+// Переносит начало координат к anchor, если тот ушёл дальше REBASE_DISTANCE.
+// Возвращает сдвиг, который надо вычесть из всех локальных координат (камера и т.п.).
+inline Vector3 RebaseOrigin(std::vector<Body>& bodies, WorldOrigin& origin, Vector3 anchor, float spacing) {
+    if (Vector3Length(anchor) < REBASE_DISTANCE) return {0,0,0};
+    Vector3 shift = { SnapToSpacing(anchor.x, spacing), SnapToSpacing(anchor.y, spacing), SnapToSpacing(anchor.z, spacing) };
+    for (Body& b : bodies) {
+        double p[3];
+        BodyOffset(b, p);
+        SetBodyOffset(b, p[0] - shift.x, p[1] - shift.y, p[2] - shift.z);
+    }
+    origin.x += shift.x;
+    origin.y += shift.y;
+    origin.z += shift.z;
+    return shift;
+}
+
+#endif
@@ -0,0 +1,393 @@
+#ifndef FMM_H
+#define FMM_H
+
+#include "gravity.h"
+#include "barnes_hut.h"
+#include "thread_pool.h"
+#include <vector>
+#include <cmath>
+
+// --- FAST MULTIPOLE METHOD ---
+// Декартовы разложения Тейлора порядка p на октодереве из barnes_hut.h.
+// Мультиполь ячейки с центром z:   M_k = sum m (x - z)^k / k!
+// Локальное разложение в центре c: phi(c + r) = sum L_n r^n,  a = G * grad(phi)
+// M2L:  L_n = 1/n! * sum_k (-1)^|k| M_k D_{k+n}(c - z),  |k| + |n| <= p,
+// где D_m — производные 1/|R|. Обход двойной (ячейка-ячейка), списки
+// взаимодействий строятся отдельно для каждой ячейки-цели, поэтому результат
+// детерминирован при любом числе потоков.
+
+const int FMM_MAX_ORDER = 8;
+const int FMM_FRONTIER_DEPTH = 3;  // ячейки этой глубины — независимые задачи для потоков
+
+struct FmmTerm { int a, b, c; };          // слагаемое вида out[a] += in[b] * t[c]
+struct FmmScaledTerm { int a, b, c; double scale; };
+
+struct FmmTables {
+    int order = -1;
+    int count = 0;                          // число мультииндексов с |k| <= order
+    std::vector<int> ex, ey, ez;            // степени по осям для каждого индекса
+    std::vector<int> degree;
+    std::vector<double> invFactorial;       // 1/k!
+    std::vector<double> factorial;          // k!
+    std::vector<double> sign;               // (-1)^|k|
+    std::vector<int> lowerX, lowerY, lowerZ;      // индекс k - e_i или -1
+    std::vector<int> lower2X, lower2Y, lower2Z;   // индекс k - 2e_i или -1
+    std::vector<int> gradX, gradY, gradZ;   // индекс k - e_i для градиента
+    std::vector<FmmTerm> m2m;               // M_k += M'_l * t^{k-l}/(k-l)!
+    std::vector<FmmTerm> m2l;               // L_n += (-1)^|k| M_k D_{k+n}   (потом * 1/n!)
+    std::vector<FmmScaledTerm> l2l;         // L'_m += L_n * C(n,m) * s^{n-m}
+};
+
+struct FmmCell {
+    int node;        // узел октодерева
+    double cx, cy, cz;
+    double radius;   // радиус шара вокруг центра, содержащего все тела ячейки
+    int firstChildCell;  // первая непустая дочерняя ячейка или -1
+    int childCount;
+    int m2lStart, m2lCount;  // диапазон в отсортированном списке M2L
+    int p2pStart, p2pCount;  // диапазон в отсортированном списке P2P (только листья)
+};
+
+struct FmmInteraction { int target, source; };
+
+struct FmmSolver {
+    FmmTables tables;
+    std::vector<FmmCell> cells;
+    std::vector<int> cellOfNode;
+    std::vector<double> multipoles;  // cells.size() * tables.count
+    std::vector<double> signedMultipoles;  // (-1)^|k| M_k для M2L
+    std::vector<double> locals;
+    std::vector<int> frontier;
+    std::vector<int> aboveFrontier;  // ячейки выше фронта, родители раньше детей
+    std::vector<std::vector<FmmInteraction>> frontierM2l, frontierP2p;
+    std::vector<int> m2lSources, p2pSources;
+    std::vector<int> counts;
+};
+
+inline int FmmTermCount(int order) {
+    return (order + 1)*(order + 2)*(order + 3)/6;
+}
+
+inline void BuildFmmTables(FmmTables& t, int order) {
+    if (t.order == order) return;
+    t = FmmTables();
+    t.order = order;
+
+    std::vector<int> lookup((order + 1)*(order + 1)*(order + 1), -1);
+    auto at = [&](int a, int b, int c) -> int {
+        if (a < 0 || b < 0 || c < 0 || a + b + c > order) return -1;
+        return lookup[(a*(order + 1) + b)*(order + 1) + c];
+    };
+    for (int n = 0; n <= order; n++) {
+        for (int a = n; a >= 0; a--) {
+            for (int b = n - a; b >= 0; b--) {
+                int c = n - a - b;
+                lookup[(a*(order + 1) + b)*(order + 1) + c] = (int)t.ex.size();
+                t.ex.push_back(a); t.ey.push_back(b); t.ez.push_back(c);
+                t.degree.push_back(n);
+            }
+        }
+    }
+    t.count = (int)t.ex.size();
+
+    double fact[FMM_MAX_ORDER + 1];
+    fact[0] = 1.0;
+    for (int n = 1; n <= FMM_MAX_ORDER; n++) fact[n] = fact[n - 1]*n;
+
+    for (int k = 0; k < t.count; k++) {
+        int a = t.ex[k], b = t.ey[k], c = t.ez[k];
+        t.factorial.push_back(fact[a]*fact[b]*fact[c]);
+        t.invFactorial.push_back(1.0/t.factorial.back());
+        t.sign.push_back((t.degree[k] % 2 == 0) ? 1.0 : -1.0);
+        t.lowerX.push_back(at(a - 1, b, c)); t.lowerY.push_back(at(a, b - 1, c)); t.lowerZ.push_back(at(a, b, c - 1));
+        t.lower2X.push_back(at(a - 2, b, c)); t.lower2Y.push_back(at(a, b - 2, c)); t.lower2Z.push_back(at(a, b, c - 2));
+        t.gradX.push_back(at(a - 1, b, c)); t.gradY.push_back(at(a, b - 1, c)); t.gradZ.push_back(at(a, b, c - 1));
+    }
+
+    for (int k = 0; k < t.count; k++) {
+        for (int l = 0; l < t.count; l++) {
+            int da = t.ex[k] - t.ex[l], db = t.ey[k] - t.ey[l], dc = t.ez[k] - t.ez[l];
+            int diff = at(da, db, dc);
+            if (diff >= 0) t.m2m.push_back({ k, l, diff });
+        }
+    }
+    for (int n = 0; n < t.count; n++) {
+        for (int k = 0; k < t.count; k++) {
+            int sum = at(t.ex[n] + t.ex[k], t.ey[n] + t.ey[k], t.ez[n] + t.ez[k]);
+            if (sum >= 0) t.m2l.push_back({ n, k, sum });
+        }
+    }
+    for (int m = 0; m < t.count; m++) {
+        for (int n = 0; n < t.count; n++) {
+            int diff = at(t.ex[n] - t.ex[m], t.ey[n] - t.ey[m], t.ez[n] - t.ez[m]);
+            if (diff < 0) continue;
+            double binom = t.factorial[n]/(t.factorial[m]*t.factorial[diff]);
+            t.l2l.push_back({ m, n, diff, binom });
+        }
+    }
+}
+
+// Одночлены d^k для всех |k| <= order
+inline void FmmMonomials(const FmmTables& t, double dx, double dy, double dz, double* out) {
+    double px[FMM_MAX_ORDER + 1], py[FMM_MAX_ORDER + 1], pz[FMM_MAX_ORDER + 1];
+    px[0] = py[0] = pz[0] = 1.0;
+    for (int n = 1; n <= t.order; n++) { px[n] = px[n - 1]*dx; py[n] = py[n - 1]*dy; pz[n] = pz[n - 1]*dz; }
+    for (int k = 0; k < t.count; k++) out[k] = px[t.ex[k]]*py[t.ey[k]]*pz[t.ez[k]];
+}
+
+// Производные D_m(R) функции 1/|R| через рекуррентность для b_m = D_m/m!:
+// |m| R^2 b_m = -(2|m|-1) sum_i R_i b_{m-e_i} - (|m|-1) sum_i b_{m-2e_i}
+inline void FmmDerivatives(const FmmTables& t, double rx, double ry, double rz, double* out) {
+    double distSq = rx*rx + ry*ry + rz*rz;
+    double invDistSq = 1.0/distSq;
+    out[0] = sqrt(invDistSq);
+    for (int k = 1; k < t.count; k++) {
+        int n = t.degree[k];
+        double first = 0.0, second = 0.0;
+        if (t.lowerX[k] >= 0) first += rx*out[t.lowerX[k]];
+        if (t.lowerY[k] >= 0) first += ry*out[t.lowerY[k]];
+        if (t.lowerZ[k] >= 0) first += rz*out[t.lowerZ[k]];
+        if (t.lower2X[k] >= 0) second += out[t.lower2X[k]];
+        if (t.lower2Y[k] >= 0) second += out[t.lower2Y[k]];
+        if (t.lower2Z[k] >= 0) second += out[t.lower2Z[k]];
+        out[k] = -((2*n - 1)*first + (n - 1)*second)*invDistSq/n;
+    }
+    for (int k = 0; k < t.count; k++) out[k] *= t.factorial[k];
+}
+
+// --- ПОСТРОЕНИЕ ЯЧЕЕК И ВОСХОДЯЩИЙ ПРОХОД ---
+inline void BuildFmmCells(FmmSolver& fmm, const Octree& tree) {
+    fmm.cells.clear();
+    fmm.cellOfNode.assign(tree.nodes.size(), -1);
+    // Узлы идут в порядке создания: родитель раньше детей
+    for (size_t n = 0; n < tree.nodes.size(); n++) {
+        const OctreeNode& node = tree.nodes[n];
+        if (node.mass <= 0.0f) continue;
+        FmmCell cell = { 0 };
+        cell.node = (int)n;
+        cell.cx = node.com.x; cell.cy = node.com.y; cell.cz = node.com.z;
+        cell.firstChildCell = -1;
+        fmm.cellOfNode[n] = (int)fmm.cells.size();
+        fmm.cells.push_back(cell);
+    }
+    // Дети одного узла создаются подряд, значит их непустые ячейки тоже идут подряд
+    for (size_t c = 0; c < fmm.cells.size(); c++) {
+        const OctreeNode& node = tree.nodes[fmm.cells[c].node];
+        if (node.firstChild < 0) continue;
+        for (int o = 0; o < 8; o++) {
+            int child = fmm.cellOfNode[node.firstChild + o];
+            if (child < 0) continue;
+            if (fmm.cells[c].firstChildCell < 0) fmm.cells[c].firstChildCell = child;
+            fmm.cells[c].childCount++;
+        }
+    }
+}
+
+inline void FmmUpward(FmmSolver& fmm, const Octree& tree) {
+    const FmmTables& t = fmm.tables;
+    fmm.multipoles.assign(fmm.cells.size()*t.count, 0.0);
+    std::vector<double> mono(t.count);
+
+    for (int c = (int)fmm.cells.size() - 1; c >= 0; c--) {
+        FmmCell& cell = fmm.cells[c];
+        const OctreeNode& node = tree.nodes[cell.node];
+        double* M = &fmm.multipoles[(size_t)c*t.count];
+        double radius = 0.0;
+
+        if (cell.firstChildCell < 0) {
+            // P2M
+            for (int k = node.firstBody; k < node.firstBody + node.bodyCount; k++) {
+                const OctreePoint& p = tree.points[k];
+                double dx = p.position.x - cell.cx, dy = p.position.y - cell.cy, dz = p.position.z - cell.cz;
+                FmmMonomials(t, dx, dy, dz, mono.data());
+                for (int i = 0; i < t.count; i++) M[i] += p.mass*mono[i]*t.invFactorial[i];
+                double dist = sqrt(dx*dx + dy*dy + dz*dz);
+                if (dist > radius) radius = dist;
+            }
+        } else {
+            // M2M
+            for (int ch = cell.firstChildCell; ch < cell.firstChildCell + cell.childCount; ch++) {
+                const FmmCell& child = fmm.cells[ch];
+                const double* Mc = &fmm.multipoles[(size_t)ch*t.count];
+                double tx = child.cx - cell.cx, ty = child.cy - cell.cy, tz = child.cz - cell.cz;
+                FmmMonomials(t, tx, ty, tz, mono.data());
+                for (int i = 0; i < t.count; i++) mono[i] *= t.invFactorial[i];
+                for (const FmmTerm& term : t.m2m) M[term.a] += Mc[term.b]*mono[term.c];
+                double reach = sqrt(tx*tx + ty*ty + tz*tz) + child.radius;
+                if (reach > radius) radius = reach;
+            }
+        }
+        cell.radius = radius;
+    }
+}
+
+// --- ДВОЙНОЙ ОБХОД ---
+inline void FmmTraverse(const FmmSolver& fmm, int a, int b, float theta, std::vector<FmmInteraction>& m2l, std::vector<FmmInteraction>& p2p) {
+    const FmmCell& A = fmm.cells[a];
+    const FmmCell& B = fmm.cells[b];
+    double dx = A.cx - B.cx, dy = A.cy - B.cy, dz = A.cz - B.cz;
+    double distSq = dx*dx + dy*dy + dz*dz;
+    double reach = A.radius + B.radius;
+
+    if (a != b && reach*reach < (double)theta*theta*distSq) {
+        m2l.push_back({ a, b });
+        return;
+    }
+    bool leafA = (A.firstChildCell < 0);
+    bool leafB = (B.firstChildCell < 0);
+    if (leafA && leafB) {
+        p2p.push_back({ a, b });
+        return;
+    }
+    if (leafB || (!leafA && A.radius >= B.radius)) {
+        for (int ch = A.firstChildCell; ch < A.firstChildCell + A.childCount; ch++) FmmTraverse(fmm, ch, b, theta, m2l, p2p);
+    } else {
+        for (int ch = B.firstChildCell; ch < B.firstChildCell + B.childCount; ch++) FmmTraverse(fmm, a, ch, theta, m2l, p2p);
+    }
+}
+
+inline void CollectFmmFrontier(FmmSolver& fmm, int c, int depth) {
+    if (depth >= FMM_FRONTIER_DEPTH || fmm.cells[c].firstChildCell < 0) {
+        fmm.frontier.push_back(c);
+        return;
+    }
+    fmm.aboveFrontier.push_back(c);
+    for (int ch = fmm.cells[c].firstChildCell; ch < fmm.cells[c].firstChildCell + fmm.cells[c].childCount; ch++) CollectFmmFrontier(fmm, ch, depth + 1);
+}
+
+// Раскладывает пары по целям (сортировка подсчётом, порядок внутри цели сохраняется)
+inline void GroupFmmInteractions(FmmSolver& fmm, const std::vector<std::vector<FmmInteraction>>& lists, std::vector<int>& sources, bool p2p) {
+    fmm.counts.assign(fmm.cells.size() + 1, 0);
+    for (const auto& list : lists) for (const FmmInteraction& it : list) fmm.counts[it.target + 1]++;
+    for (size_t c = 0; c < fmm.cells.size(); c++) {
+        if (p2p) { fmm.cells[c].p2pStart = fmm.counts[c]; fmm.cells[c].p2pCount = fmm.counts[c + 1]; }
+        else { fmm.cells[c].m2lStart = fmm.counts[c]; fmm.cells[c].m2lCount = fmm.counts[c + 1]; }
+        fmm.counts[c + 1] += fmm.counts[c];
+    }
+    sources.resize(fmm.counts.back());
+    for (const auto& list : lists) for (const FmmInteraction& it : list) sources[fmm.counts[it.target]++] = it.source;
+}
+
+// --- НИСХОДЯЩИЙ ПРОХОД ---
+inline void FmmLocalToChild(const FmmSolver& fmm, const FmmCell& parent, const FmmCell& child, const double* Lp, double* Lc, double* mono) {
+    const FmmTables& t = fmm.tables;
+    FmmMonomials(t, child.cx - parent.cx, child.cy - parent.cy, child.cz - parent.cz, mono);
+    for (const FmmScaledTerm& term : t.l2l) Lc[term.a] += Lp[term.b]*term.scale*mono[term.c];
+}
+
+inline void FmmLeafAccelerations(const FmmSolver& fmm, const Octree& tree, int c, std::vector<Vector3>& acc, const std::vector<Body>& bodies, double* mono) {
+    const FmmTables& t = fmm.tables;
+    const FmmCell& cell = fmm.cells[c];
+    const OctreeNode& node = tree.nodes[cell.node];
+    const double* L = &fmm.locals[(size_t)c*t.count];
+
+    for (int k = node.firstBody; k < node.firstBody + node.bodyCount; k++) {
+        int body = tree.order[k];
+        if (bodies[body].isFixed) continue;
+        Vector3 pos = tree.points[k].position;
+
+        // L2P: градиент локального разложения
+        FmmMonomials(t, pos.x - cell.cx, pos.y - cell.cy, pos.z - cell.cz, mono);
+        double gx = 0.0, gy = 0.0, gz = 0.0;
+        for (int n = 1; n < t.count; n++) {
+            if (t.gradX[n] >= 0) gx += L[n]*t.ex[n]*mono[t.gradX[n]];
+            if (t.gradY[n] >= 0) gy += L[n]*t.ey[n]*mono[t.gradY[n]];
+            if (t.gradZ[n] >= 0) gz += L[n]*t.ez[n]*mono[t.gradZ[n]];
+        }
+
+        // P2P: ближние листья напрямую
+        float ax = 0.0f, ay = 0.0f, az = 0.0f;
+        for (int s = cell.p2pStart; s < cell.p2pStart + cell.p2pCount; s++) {
+            const OctreeNode& src = tree.nodes[fmm.cells[fmm.p2pSources[s]].node];
+            for (int j = src.firstBody; j < src.firstBody + src.bodyCount; j++) {
+                if (j == k) continue;
+                const OctreePoint& p = tree.points[j];
+                float dx = p.position.x - pos.x, dy = p.position.y - pos.y, dz = p.position.z - pos.z;
+                float distSq = dx*dx + dy*dy + dz*dz;
+                if (distSq <= 0.0f) continue;
+                float scale = p.mass/(distSq*sqrtf(distSq));
+                ax += dx*scale; ay += dy*scale; az += dz*scale;
+            }
+        }
+        acc[body] = { G*(float)(gx + ax), G*(float)(gy + ay), G*(float)(gz + az) };
+    }
+}
+
+inline void FmmDownward(const FmmSolver& fmm, const Octree& tree, int c, std::vector<Vector3>& acc, const std::vector<Body>& bodies, std::vector<double>& mono, std::vector<double>& locals) {
+    const FmmCell& cell = fmm.cells[c];
+    if (cell.firstChildCell < 0) {
+        FmmLeafAccelerations(fmm, tree, c, acc, bodies, mono.data());
+        return;
+    }
+    const FmmTables& t = fmm.tables;
+    for (int ch = cell.firstChildCell; ch < cell.firstChildCell + cell.childCount; ch++) {
+        FmmLocalToChild(fmm, cell, fmm.cells[ch], &locals[(size_t)c*t.count], &locals[(size_t)ch*t.count], mono.data());
+        FmmDownward(fmm, tree, ch, acc, bodies, mono, locals);
+    }
+}
+
+inline void ComputeAccelerationsFmm(const std::vector<Body>& bodies, std::vector<Vector3>& acc, Octree& tree, FmmSolver& fmm, float theta, int order, int leafSize, ThreadPool* pool) {
+    acc.assign(bodies.size(), {0,0,0});
+    if (bodies.empty()) return;
+    if (order < 1) order = 1;
+    if (order > FMM_MAX_ORDER) order = FMM_MAX_ORDER;
+    if (theta <= 0.0f) theta = 0.01f;
+
+    BuildFmmTables(fmm.tables, order);
+    const FmmTables& t = fmm.tables;
+    BuildOctree(tree, bodies, leafSize);
+    BuildFmmCells(fmm, tree);
+    FmmUpward(fmm, tree);
+
+    // Списки взаимодействий: каждая ячейка фронта — отдельная задача
+    fmm.frontier.clear();
+    fmm.aboveFrontier.clear();
+    CollectFmmFrontier(fmm, 0, 0);
+    fmm.frontierM2l.resize(fmm.frontier.size());
+    fmm.frontierP2p.resize(fmm.frontier.size());
+    ParallelFor(pool, fmm.frontier.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; f++) {
+            fmm.frontierM2l[f].clear();
+            fmm.frontierP2p[f].clear();
+            FmmTraverse(fmm, fmm.frontier[f], 0, theta, fmm.frontierM2l[f], fmm.frontierP2p[f]);
+        }
+    });
+    GroupFmmInteractions(fmm, fmm.frontierM2l, fmm.m2lSources, false);
+    GroupFmmInteractions(fmm, fmm.frontierP2p, fmm.p2pSources, true);
+
+    // M2L: знак (-1)^|k| вносим в мультиполи заранее, множитель 1/n! — после суммы
+    fmm.signedMultipoles.resize(fmm.multipoles.size());
+    for (size_t i = 0; i < fmm.multipoles.size(); i++) fmm.signedMultipoles[i] = fmm.multipoles[i]*t.sign[i % t.count];
+    fmm.locals.assign(fmm.cells.size()*t.count, 0.0);
+    ParallelFor(pool, fmm.cells.size(), 64, [&](size_t begin, size_t end) {
+        std::vector<double> deriv(t.count);
+        for (size_t c = begin; c < end; c++) {
+            const FmmCell& cell = fmm.cells[c];
+            double* L = &fmm.locals[c*t.count];
+            if (cell.m2lCount == 0) continue;
+            for (int s = cell.m2lStart; s < cell.m2lStart + cell.m2lCount; s++) {
+                int src = fmm.m2lSources[s];
+                const FmmCell& source = fmm.cells[src];
+                const double* M = &fmm.signedMultipoles[(size_t)src*t.count];
+                FmmDerivatives(t, cell.cx - source.cx, cell.cy - source.cy, cell.cz - source.cz, deriv.data());
+                for (const FmmTerm& term : t.m2l) L[term.a] += M[term.b]*deriv[term.c];
+            }
+            for (int n = 0; n < t.count; n++) L[n] *= t.invFactorial[n];
+        }
+    });
+
+    // L2L выше фронта — последовательно, ниже — по задачам фронта
+    std::vector<double> mono(t.count);
+    for (int c : fmm.aboveFrontier) {
+        const FmmCell& cell = fmm.cells[c];
+        for (int ch = cell.firstChildCell; ch < cell.firstChildCell + cell.childCount; ch++) {
+            FmmLocalToChild(fmm, cell, fmm.cells[ch], &fmm.locals[(size_t)c*t.count], &fmm.locals[(size_t)ch*t.count], mono.data());
+        }
+    }
+    ParallelFor(pool, fmm.frontier.size(), 1, [&](size_t begin, size_t end) {
+        std::vector<double> scratch(t.count);
+        for (size_t f = begin; f < end; f++) FmmDownward(fmm, tree, fmm.frontier[f], acc, bodies, scratch, fmm.locals);
+    });
+}
+
+#endif
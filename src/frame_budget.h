@@ -0,0 +1,125 @@
+#ifndef FRAME_BUDGET_H
+#define FRAME_BUDGET_H
+
+#include <cmath>
+#include <algorithm>
+
+// --- БЮДЖЕТ КАДРА ---
+// Две главные статьи расхода кадра — шаги физики и сетка пространства-времени.
+// Регулятор сглаживает их время и раз в несколько кадров сдвигает на одну
+// ступень один рычаг:
+//   перебор — реже сетка (если она дороже физики), меньше подшагов (шаг
+//             крупнее, скорость симуляции та же), медленнее время;
+//   запас   — в обратном порядке, и подшагов больше стандартных, пока
+//             лёгкая сцена оставляет процессор без дела.
+// Поднимаемся, только если прогноз после шага укладывается в запас, —
+// иначе регулятор качался бы между двумя соседними ступенями.
+// Решаем по среднему за все кадры текущего режима, а не по сглаженному
+// значению: тяжёлый тик физики приходит раз в несколько кадров, и сглаженное
+// время пилой скачет от нуля до цены тика. Вниз идём по среднему — перебор
+// надо снимать быстро, — вверх по верхней границе среднего (две стандартные
+// ошибки), чтобы пара недостающих в окне тиков не выдала себя за запас.
+
+const float BUDGET_TARGET_MS = 16.0f;     // цель: физика + сетка за кадр
+const float BUDGET_HEADROOM = 0.8f;       // поднимаем, если прогноз ниже этой доли цели
+const int BUDGET_MIN_SUBSTEPS = 2;
+const int BUDGET_MAX_SUBSTEPS = 16;
+const int BUDGET_MAX_GRID_STRIDE = 4;     // сетка реже не больше чем вчетверо по оси (1, 2, 4)
+const float BUDGET_MIN_TIME_SCALE = 0.25f;
+const int BUDGET_SETTLE_FRAMES = 20;      // кадров на то, чтобы сглаженное время догнало решение
+const int BUDGET_WINDOW_FRAMES = 80;      // окно среднего; старые кадры дальше забываются вдвое
+const float BUDGET_SMOOTHING = 0.1f;      // сглаживание для показа на экране
+
+struct FrameGovernor {
+    float targetMs;
+    bool enabled;
+    int substeps;     // тиков физики на кадр 60 Гц
+    int gridStride;   // шаг сетки в stride раз крупнее; степень двойки, чтобы
+                      // линии всех ступеней совпадали и при переносе начала координат
+    float timeScale;  // доля заказанной скорости времени, которую физика тянет
+    float physicsMs;  // затраты на кадр: сглаженные, на решении — среднее окна
+    float gridMs;
+    int settle;       // кадров до следующего решения
+    float windowPhysicsMs;  // суммы с последнего изменения режима
+    float windowGridMs;
+    float windowSquares;    // сумма квадратов затрат кадра — для разброса среднего
+    int windowFrames;
+};
+
+inline FrameGovernor MakeFrameGovernor(float targetMs, int substeps, bool enabled) {
+    return { targetMs, enabled, substeps, 1, 1.0f, 0.0f, 0.0f, BUDGET_SETTLE_FRAMES, 0.0f, 0.0f, 0.0f, 0 };
+}
+
+// Прогноз затрат, если подшагов станет substeps, а сетка — stride:
+// физика линейна по числу шагов, сетка — по числу узлов
+inline float PredictFrameCost(const FrameGovernor& g, int substeps, int stride, float timeScale) {
+    float physics = g.physicsMs*(float)substeps/g.substeps*timeScale/g.timeScale;
+    float ratio = (float)g.gridStride/stride;
+    return physics + g.gridMs*ratio*ratio;
+}
+
+// Раз за кадр: физика и сетка этого кадра, мс. true — решение изменилось.
+inline bool UpdateFrameGovernor(FrameGovernor& g, float physicsMs, float gridMs) {
+    g.physicsMs += BUDGET_SMOOTHING*(physicsMs - g.physicsMs);
+    g.gridMs += BUDGET_SMOOTHING*(gridMs - g.gridMs);
+    g.windowPhysicsMs += physicsMs;
+    g.windowGridMs += gridMs;
+    g.windowSquares += (physicsMs + gridMs)*(physicsMs + gridMs);
+    g.windowFrames++;
+    if (g.windowFrames >= BUDGET_WINDOW_FRAMES) {
+        g.windowPhysicsMs *= 0.5f;
+        g.windowGridMs *= 0.5f;
+        g.windowSquares *= 0.5f;
+        g.windowFrames /= 2;
+    }
+    if (!g.enabled || --g.settle > 0) return false;
+
+    g.physicsMs = g.windowPhysicsMs/g.windowFrames;
+    g.gridMs = g.windowGridMs/g.windowFrames;
+
+    float cost = g.physicsMs + g.gridMs;
+    float variance = std::max(0.0f, g.windowSquares/g.windowFrames - cost*cost);
+    float upper = (cost > 0.0f) ? 1.0f + 2.0f*std::sqrt(variance/g.windowFrames)/cost : 1.0f;
+    FrameGovernor before = g;
+    bool changed = false;
+    if (cost > g.targetMs) {
+        bool gridFirst = g.gridMs > g.physicsMs && g.gridStride < BUDGET_MAX_GRID_STRIDE;
+        if (gridFirst) { g.gridStride *= 2; changed = true; }
+        else if (g.substeps > BUDGET_MIN_SUBSTEPS) { g.substeps--; changed = true; }
+        else if (g.gridStride < BUDGET_MAX_GRID_STRIDE) { g.gridStride *= 2; changed = true; }
+        else if (g.timeScale > BUDGET_MIN_TIME_SCALE) {
+            // Дальше ужимать нечего: пусть время идёт медленнее, но ровно.
+            // Целимся в середину полосы между запасом и целью, чтобы шум
+            // не перекидывал регулятор через цель и обратно
+            float aim = 0.5f*(1.0f + BUDGET_HEADROOM)*g.targetMs;
+            g.timeScale = std::max(BUDGET_MIN_TIME_SCALE, g.timeScale*aim/cost);
+            changed = true;
+        }
+    } else {
+        float room = BUDGET_HEADROOM*g.targetMs/upper;
+        float scale = std::min(1.0f, g.timeScale*1.25f);
+        if (g.timeScale < 1.0f) {
+            if (PredictFrameCost(g, g.substeps, g.gridStride, scale) < room) { g.timeScale = scale; changed = true; }
+        } else if (g.gridStride > 1 && PredictFrameCost(g, g.substeps, g.gridStride/2, 1.0f) < room) {
+            g.gridStride /= 2;
+            changed = true;
+        } else if (g.substeps < BUDGET_MAX_SUBSTEPS && PredictFrameCost(g, g.substeps + 1, g.gridStride, 1.0f) < room) {
+            g.substeps++;
+            changed = true;
+        }
+    }
+    g.settle = changed ? BUDGET_SETTLE_FRAMES : 1;
+    if (!changed) return false;
+    // Сглаженное время переводим на новый режим по прогнозу, чтобы
+    // следующее решение не опиралось на затраты старого
+    float ratio = (float)before.gridStride/g.gridStride;
+    g.physicsMs = before.physicsMs*(float)g.substeps/before.substeps*g.timeScale/before.timeScale;
+    g.gridMs = before.gridMs*ratio*ratio;
+    g.windowPhysicsMs = 0.0f;
+    g.windowGridMs = 0.0f;
+    g.windowSquares = 0.0f;
+    g.windowFrames = 0;
+    return true;
+}
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef GRAVITY_H
+#define GRAVITY_H
+
+#include "raylib.h"
+#include "raymath.h"
+#include <vector>
+#include <cmath>
+
+// --- КОНСТАНТЫ ---
+const float G = 500.0f;
+
+// --- СТРУКТУРЫ ---
+struct Body {
+    Vector3 position;    // относительно плавающего начала координат
+    Vector3 velocity;
+    float mass;
+    float radius;
+    Color color;
+    bool isFixed;
+    Vector3 positionLo = {0,0,0};  // младшая часть позиции: то, что не влезло в float
+};
+
+// Способ расчёта гравитации
+enum GravitySolver {
+    SOLVER_DIRECT = 0,   // прямая сумма O(N^2)
+    SOLVER_PAIRWISE,     // прямая сумма, каждая пара один раз
+    SOLVER_BARNES_HUT,   // октодерево O(N log N)
+    SOLVER_FMM,          // быстрый метод мультиполей O(N)
+    SOLVER_PM,           // частицы-сетка через БПФ
+    SOLVER_COUNT
+};
+
+// Границы сетки particle-mesh
+enum PmBoundary {
+    PM_ISOLATED = 0,  // поле уходит в бесконечность, сетка следует за телами
+    PM_PERIODIC       // периодический куб вокруг начала координат
+};
+
+// Схема интегрирования по времени
+enum Integrator {
+    INTEGRATOR_EULER = 0,  // полунеявный Эйлер, первый порядок
+    INTEGRATOR_LEAPFROG,   // kick-drift-kick, второй порядок, симплектический
+    INTEGRATOR_ADAPTIVE,   // kick-drift-kick с собственным шагом у каждого тела
+    INTEGRATOR_HERMITE,    // Эрмит 4-го порядка с блочными шагами
+    INTEGRATOR_WISDOM_HOLMAN, // дрейф по Кеплеру вокруг звезды + толчки от остальных
+    INTEGRATOR_COUNT
+};
+
+struct GravitySettings {
+    GravitySolver solver;
+    float theta;      // угол раскрытия Barnes-Hut (0 = прямая сумма)
+    int leafSize;     // максимум тел в листе октодерева
+    float tolerance;  // допустимая относительная ошибка против прямой суммы
+    int fmmOrder;     // порядок разложений FMM
+    int fmmLeafSize;  // максимум тел в листе для FMM
+    int pmGrid;       // ячеек сетки PM по оси (степень двойки)
+    PmBoundary pmBoundary;
+    float pmBoxSize;  // сторона периодического куба
+    Integrator integrator;
+    bool regularize;  // тесные пары leapfrog переносить по Кеплеру (encounters.h)
+    bool tiledDirect; // блочная прямая сумма вместо построчной (direct_kernel.h)
+};
+
+inline GravitySettings DefaultGravitySettings() {
+    return { SOLVER_DIRECT, 0.5f, 8, 0.01f, 4, 32, 64, PM_ISOLATED, 400.0f, INTEGRATOR_LEAPFROG, true, false };
+}
+
+inline const char* GravitySolverName(GravitySolver solver) {
+    switch (solver) {
+        case SOLVER_DIRECT: return "direct";
+        case SOLVER_PAIRWISE: return "pair";
+        case SOLVER_BARNES_HUT: return "bh";
+        case SOLVER_FMM: return "fmm";
+        case SOLVER_PM: return "pm";
+        default: return "?";
+    }
+}
+
+inline const char* IntegratorName(Integrator integrator) {
+    switch (integrator) {
+        case INTEGRATOR_EULER: return "euler";
+        case INTEGRATOR_LEAPFROG: return "leapfrog";
+        case INTEGRATOR_ADAPTIVE: return "adaptive";
+        case INTEGRATOR_HERMITE: return "hermite";
+        case INTEGRATOR_WISDOM_HOLMAN: return "wh";
+        default: return "?";
+    }
+}
+
+inline const char* PmBoundaryName(PmBoundary boundary) {
+    return (boundary == PM_PERIODIC) ? "periodic" : "isolated";
+}
+
+// --- ПРЯМАЯ СУММА ---
+// Эталон: тот же расчёт, что был в main() — сила на тело, затем деление на массу.
+// Ускорения пишутся только для подвижных тел. Смягчения нет (прежнее
+// ограничение dist радиусами в силу не входило): тесные пары разбирает
+// encounters.h.
+inline void ComputeAccelerationsReference(const std::vector<Body>& bodies, std::vector<Vector3>& acc) {
+    acc.assign(bodies.size(), {0,0,0});
+    for (size_t i = 0; i < bodies.size(); i++) {
+        if (bodies[i].isFixed) continue;
+        Vector3 totalForce = {0,0,0};
+        for (size_t j = 0; j < bodies.size(); j++) {
+            if (i==j) continue;
+            Vector3 diff = Vector3Subtract(bodies[j].position, bodies[i].position);
+            float distSq = Vector3LengthSqr(diff);
+            float force = (G * bodies[i].mass * bodies[j].mass) / distSq;
+            totalForce = Vector3Add(totalForce, Vector3Scale(Vector3Normalize(diff), force));
+        }
+        acc[i] = Vector3Scale(totalForce, 1.0f/bodies[i].mass);
+    }
+}
+
+// Максимальная относительная ошибка ускорений против эталона (по подвижным телам)
+inline float MaxRelativeError(const std::vector<Body>& bodies, const std::vector<Vector3>& acc, const std::vector<Vector3>& ref) {
+    float maxErr = 0.0f;
+    for (size_t i = 0; i < bodies.size(); i++) {
+        if (bodies[i].isFixed) continue;
+        float refLen = Vector3Length(ref[i]);
+        if (refLen <= 0.0f) continue;
+        float err = Vector3Length(Vector3Subtract(acc[i], ref[i])) / refLen;
+        if (err > maxErr) maxErr = err;
+    }
+    return maxErr;
+}
+
+#endif
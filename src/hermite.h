@@ -0,0 +1,168 @@
+#ifndef HERMITE_H
+#define HERMITE_H
+
+#include "gravity.h"
+#include "floating_origin.h"
+#include "thread_pool.h"
+#include "block_steps.h"
+#include <vector>
+#include <cmath>
+
+// --- ЭРМИТ 4-ГО ПОРЯДКА С БЛОЧНЫМИ ШАГАМИ ---
+// Предиктор-корректор: ускорение и его производная (рывок) считаются одним
+// проходом прямой суммы в double. Шаги тел раздаёт планировщик блоков
+// (block_steps.h), так что тесная пара мельчит шаг только себе.
+// Решатель из настроек здесь не используется: рывок есть только у прямой суммы.
+
+const double HERMITE_ETA = 0.02;       // критерий Аарсета для корректора
+const double HERMITE_ETA_START = 0.01; // первый шаг по |a|/|j|
+
+struct HermiteBody {
+    double x[3], v[3];    // на время последнего обновления
+    double a[3], j[3];
+    double xp[3], vp[3];  // предсказание на текущий блок
+};
+
+struct HermiteState {
+    std::vector<HermiteBody> bodies;
+    std::vector<double> mass;
+    std::vector<double> force;  // a и j активных тел, по 6 чисел
+    BlockScheduler blocks;
+    bool valid = false;
+    double outer = 0.0;         // длина внешнего шага, под которую выбраны шаги тел
+};
+
+inline double Dot3(const double* a, const double* b) {
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+// Ускорение и рывок на тело i от предсказанных положений всех остальных
+inline void HermiteForce(const HermiteState& hs, int i, double* acc, double* jerk) {
+    const HermiteBody& bi = hs.bodies[i];
+    double ax = 0.0, ay = 0.0, az = 0.0, jx = 0.0, jy = 0.0, jz = 0.0;
+    for (size_t k = 0; k < hs.bodies.size(); k++) {
+        if ((int)k == i) continue;
+        const HermiteBody& bk = hs.bodies[k];
+        double dx = bk.xp[0] - bi.xp[0], dy = bk.xp[1] - bi.xp[1], dz = bk.xp[2] - bi.xp[2];
+        double dvx = bk.vp[0] - bi.vp[0], dvy = bk.vp[1] - bi.vp[1], dvz = bk.vp[2] - bi.vp[2];
+        double r2 = dx*dx + dy*dy + dz*dz;
+        if (r2 <= 0.0) continue;
+        double rinv = 1.0/sqrt(r2);
+        double mr3 = hs.mass[k]*rinv*rinv*rinv;
+        double rv = 3.0*(dx*dvx + dy*dvy + dz*dvz)/r2;
+        ax += mr3*dx; ay += mr3*dy; az += mr3*dz;
+        jx += mr3*(dvx - rv*dx); jy += mr3*(dvy - rv*dy); jz += mr3*(dvz - rv*dz);
+    }
+    acc[0] = G*ax; acc[1] = G*ay; acc[2] = G*az;
+    jerk[0] = G*jx; jerk[1] = G*jy; jerk[2] = G*jz;
+}
+
+inline void PredictHermiteBody(HermiteBody& b, double tau) {
+    for (int c = 0; c < 3; c++) {
+        b.xp[c] = b.x[c] + tau*(b.v[c] + tau*(0.5*b.a[c] + tau*b.j[c]/6.0));
+        b.vp[c] = b.v[c] + tau*(b.a[c] + tau*0.5*b.j[c]);
+    }
+}
+
+inline void InitHermite(HermiteState& hs, const std::vector<Body>& bodies, double outer, ThreadPool* pool) {
+    size_t n = bodies.size();
+    hs.bodies.resize(n);
+    hs.mass.resize(n);
+    std::vector<unsigned char> fixed(n);
+    for (size_t i = 0; i < n; i++) {
+        HermiteBody& h = hs.bodies[i];
+        BodyOffset(bodies[i], h.x);
+        h.v[0] = bodies[i].velocity.x; h.v[1] = bodies[i].velocity.y; h.v[2] = bodies[i].velocity.z;
+        for (int c = 0; c < 3; c++) { h.xp[c] = h.x[c]; h.vp[c] = h.v[c]; }
+        hs.mass[i] = bodies[i].mass;
+        fixed[i] = bodies[i].isFixed ? 1 : 0;
+    }
+    ResetBlockScheduler(hs.blocks, fixed);
+    ParallelFor(pool, n, 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            HermiteBody& h = hs.bodies[i];
+            HermiteForce(hs, (int)i, h.a, h.j);
+        }
+    });
+    double quantum = outer/(double)BLOCK_FULL;
+    for (size_t i = 0; i < n; i++) {
+        const HermiteBody& h = hs.bodies[i];
+        double a = sqrt(Dot3(h.a, h.a)), j = sqrt(Dot3(h.j, h.j));
+        double want = (j > 0.0) ? HERMITE_ETA_START*a/j : outer;
+        hs.blocks.step[i] = QuantizeBlockStep(want, quantum, 0);
+    }
+    hs.outer = outer;
+    hs.valid = true;
+}
+
+// Сдвиг начала координат (floating origin) без потери состояния. Сдвигается
+// и предсказание: закреплённые тела заново не предсказываются, их xp живёт
+// от инициализации.
+inline void ShiftHermite(HermiteState& hs, Vector3 shift) {
+    for (HermiteBody& h : hs.bodies) {
+        h.x[0] -= shift.x; h.x[1] -= shift.y; h.x[2] -= shift.z;
+        h.xp[0] -= shift.x; h.xp[1] -= shift.y; h.xp[2] -= shift.z;
+    }
+}
+
+// Один внешний шаг длины outerStep; тела возвращаются в bodies синхронными
+inline void StepHermite(std::vector<Body>& bodies, float outerStep, HermiteState& hs, ThreadPool* pool) {
+    double outer = outerStep;
+    // Шаги тел — доли внешнего; сменилась скорость времени — выбираем заново
+    if (!hs.valid || hs.bodies.size() != bodies.size() || hs.outer != outer) InitHermite(hs, bodies, outer, pool);
+    double quantum = outer/(double)BLOCK_FULL;
+    BlockScheduler& sched = hs.blocks;
+    BeginBlockStats(sched);
+
+    for (;;) {
+        uint64_t next = CollectActiveBodies(sched);
+        if (sched.active.empty()) break;  // одни закреплённые тела
+        for (size_t i = 0; i < hs.bodies.size(); i++) {
+            if (!sched.fixed[i]) PredictHermiteBody(hs.bodies[i], (double)(next - sched.time[i])*quantum);
+        }
+
+        // Сначала силы на все активные тела по предсказанию, потом коррекция:
+        // иначе тело читало бы уже исправленные позиции соседей по блоку
+        hs.force.resize(6*sched.active.size());
+        ParallelFor(pool, sched.active.size(), 4, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; k++) HermiteForce(hs, sched.active[k], &hs.force[6*k], &hs.force[6*k + 3]);
+        });
+        for (size_t k = 0; k < sched.active.size(); k++) {
+            int i = sched.active[k];
+            HermiteBody& h = hs.bodies[i];
+            const double* a1 = &hs.force[6*k];
+            const double* j1 = &hs.force[6*k + 3];
+            // Корректор: снап и крекл из a, j на концах шага
+            double step = (double)sched.step[i]*quantum;
+            double s2 = step*step;
+            double snap[3], crackle[3];
+            for (int c = 0; c < 3; c++) {
+                snap[c] = (-6.0*(h.a[c] - a1[c]) - step*(4.0*h.j[c] + 2.0*j1[c]))/s2;
+                crackle[c] = (12.0*(h.a[c] - a1[c]) + 6.0*step*(h.j[c] + j1[c]))/(s2*step);
+                h.x[c] = h.xp[c] + s2*s2*(snap[c]/24.0 + step*crackle[c]/120.0);
+                h.v[c] = h.vp[c] + s2*step*(snap[c]/6.0 + step*crackle[c]/24.0);
+                h.a[c] = a1[c];
+                h.j[c] = j1[c];
+                snap[c] += step*crackle[c];  // снап на конец шага
+            }
+            sched.time[i] = next;
+            // Критерий Аарсета
+            double a = sqrt(Dot3(a1, a1)), j = sqrt(Dot3(j1, j1));
+            double sn = sqrt(Dot3(snap, snap)), cr = sqrt(Dot3(crackle, crackle));
+            double denom = j*cr + sn*sn;
+            AdaptBlockStep(sched, i, (denom > 0.0) ? sqrt(HERMITE_ETA*(a*sn + j*j)/denom) : outer, quantum);
+        }
+        FinishBlock(sched);
+        if (next == BLOCK_FULL) break;
+    }
+    EndBlockStep(sched);
+
+    for (size_t i = 0; i < hs.bodies.size(); i++) {
+        if (sched.fixed[i]) continue;
+        const HermiteBody& h = hs.bodies[i];
+        SetBodyOffset(bodies[i], h.x[0], h.x[1], h.x[2]);
+        bodies[i].velocity = { (float)h.v[0], (float)h.v[1], (float)h.v[2] };
+    }
+}
+
+#endif
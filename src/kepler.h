@@ -0,0 +1,89 @@
+#ifndef KEPLER_H
+#define KEPLER_H
+
+#include "raylib.h"
+#include <cmath>
+
+// --- ЗАДАЧА КЕПЛЕРА ---
+// Точный перенос тела по орбите вокруг неподвижного центра за время dt
+// в универсальных переменных: одна формула для эллипса, параболы и
+// гиперболы. Уравнение Кеплера решается методом Лагерра — он сходится
+// и там, где Ньютон уходит в сторону (почти параболические орбиты).
+
+// Функции Штумпфа c2(z) и c3(z); у нуля — ряд, чтобы не терять точность
+inline void Stumpff(double z, double* c2, double* c3) {
+    if (fabs(z) < 1e-3) {
+        *c2 = 0.5 - z*(1.0/24.0 - z/720.0);
+        *c3 = 1.0/6.0 - z*(1.0/120.0 - z/5040.0);
+    } else if (z > 0.0) {
+        double s = sqrt(z);
+        *c2 = (1.0 - cos(s))/z;
+        *c3 = (s - sin(s))/(z*s);
+    } else {
+        double s = sqrt(-z);
+        *c2 = (cosh(s) - 1.0)/(-z);
+        *c3 = (sinh(s) - s)/(-z*s);
+    }
+}
+
+// r, v — относительно центра с параметром gm = G*M; на выходе — через dt.
+// false — итерации не сошлись (r, v не тронуты).
+inline bool KeplerDrift(double gm, double r[3], double v[3], double dt) {
+    double r0 = sqrt(r[0]*r[0] + r[1]*r[1] + r[2]*r[2]);
+    if (r0 <= 0.0 || gm <= 0.0) return false;
+    double v2 = v[0]*v[0] + v[1]*v[1] + v[2]*v[2];
+    double rv = r[0]*v[0] + r[1]*v[1] + r[2]*v[2];
+    double sqrtGm = sqrt(gm);
+    double alpha = 2.0/r0 - v2/gm;  // 1/a; < 0 у гиперболы
+    double sigma = rv/sqrtGm;
+
+    // Универсальная аномалия chi: F(chi) = 0
+    double chi = (alpha > 0.0) ? sqrtGm*dt*alpha : sqrtGm*dt/r0;
+    const double N = 5.0;
+    bool converged = false;
+    double c2 = 0.5, c3 = 1.0/6.0, rn = r0;
+    for (int iter = 0; iter < 50; iter++) {
+        double chi2 = chi*chi;
+        double z = alpha*chi2;
+        Stumpff(z, &c2, &c3);
+        double f = sigma*chi2*c2 + (1.0 - alpha*r0)*chi2*chi*c3 + r0*chi - sqrtGm*dt;
+        rn = sigma*chi*(1.0 - z*c3) + (1.0 - alpha*r0)*chi2*c2 + r0;  // F' = |r| в момент dt
+        double fpp = sigma*(1.0 - z*c2) + (1.0 - alpha*r0)*chi*(1.0 - z*c3);
+        double disc = fabs((N - 1.0)*(N - 1.0)*rn*rn - N*(N - 1.0)*f*fpp);
+        double denom = rn + ((rn >= 0.0) ? 1.0 : -1.0)*sqrt(disc);
+        if (denom == 0.0) break;
+        double delta = N*f/denom;
+        chi -= delta;
+        if (fabs(delta) <= 1e-13*fmax(1.0, fabs(chi))) { converged = true; break; }
+    }
+    if (!converged) return false;
+
+    // Коэффициенты Лагранжа для найденного chi
+    double chi2 = chi*chi;
+    double z = alpha*chi2;
+    Stumpff(z, &c2, &c3);
+    rn = sigma*chi*(1.0 - z*c3) + (1.0 - alpha*r0)*chi2*c2 + r0;
+    double f = 1.0 - chi2*c2/r0;
+    double g = dt - chi2*chi*c3/sqrtGm;
+    double fdot = sqrtGm*chi*(z*c3 - 1.0)/(rn*r0);
+    double gdot = 1.0 - chi2*c2/rn;
+    for (int c = 0; c < 3; c++) {
+        double rc = f*r[c] + g*v[c];
+        double vc = fdot*r[c] + gdot*v[c];
+        r[c] = rc;
+        v[c] = vc;
+    }
+    return true;
+}
+
+// Период эллиптической орбиты; 0 — орбита не замкнута
+inline double KeplerPeriod(double gm, const double r[3], const double v[3]) {
+    double r0 = sqrt(r[0]*r[0] + r[1]*r[1] + r[2]*r[2]);
+    if (r0 <= 0.0 || gm <= 0.0) return 0.0;
+    double alpha = 2.0/r0 - (v[0]*v[0] + v[1]*v[1] + v[2]*v[2])/gm;
+    if (alpha <= 0.0) return 0.0;
+    double a = 1.0/alpha;
+    return 2.0*PI*sqrt(a*a*a/gm);
+}
+
+#endif
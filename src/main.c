@@ -1,27 +1,21 @@
 #include "raylib.h"
 #include "raymath.h"
+#include "physics.h"
+#include "scenes.h"
+#include "config.h"
+#include "bench.h"
+#include "physics_thread.h"
 #include <vector>
 #include <string>
 #include <cmath>
 #include <algorithm>
 
 // --- КОНСТАНТЫ ---
-const float G = 500.0f;
-const float BASE_DT = 0.0005f; 
-const int SUBSTEPS = 8;
 const int GRID_SIZE = 50;
 const float GRID_SPACING = 4.0f;
+const int LOWPOLY_BODIES = 2000;     // с этого числа тел рисуем упрощённые сферы
 
 // --- СТРУКТУРЫ ---
-struct Body {
-    Vector3 position;
-    Vector3 velocity;
-    float mass;
-    float radius;
-    Color color;
-    bool isFixed;
-};
-
 struct PlanetBuilder {
     bool active;
     Vector3 startPos; 
@@ -74,7 +68,24 @@ bool GuiButton(Rectangle rect, const char* text, Color color) {
     return pressed;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    AppConfig config = DefaultAppConfig();
+    ParseCommandLine(argc, argv, &config);
+
+    // Набор команд: автовыбор, затем GRAVITY_ISA, затем --isa
+    ApplyIsaEnvironment();
+    if (config.isa != ISA_COUNT) SelectIsa(config.isa);
+    TraceLog(LOG_INFO, "CPU: best %s, using %s", IsaName(DetectBestIsa()), IsaName(ActiveIsa()));
+
+    ThreadPool pool;
+    StartThreadPool(pool, config.threads, config.pinCpus);
+
+    if (config.benchmark) {
+        RunBenchmarks(&pool);
+        StopThreadPool(pool);
+        return 0;
+    }
+
     // ВАЖНО: 0,0 означает полный экран на Android/Termux
     InitWindow(0, 0, "Gravity Mobile");
     SetTargetFPS(60);
@@ -90,11 +101,23 @@ int main() {
     camera.fovy = 45.0f;
     camera.projection = CAMERA_PERSPECTIVE;
 
-    std::vector<Body> bodies;
+    std::vector<Body> heavyBodies; // только тела, заметно прогибающие сетку
     
     // Стартовый пресет
-    bodies.push_back({ {0,0,0}, {0,0,0}, 5000.0f, 10.0f, GOLD, true });
-    bodies.push_back({ {50,0,0}, {0,0,310.0f}, 100.0f, 3.0f, SKYBLUE, false });
+    std::vector<Body> sceneBodies;
+    LoadScene(sceneBodies, config.scene, config.bodyCount);
+
+    // Физика считает в своём потоке; отсюда уходят только команды
+    GravitySettings gravity = config.gravity; // копия интерфейса, физике уходит командой
+    PhysicsSim sim;
+    sim.collide = config.collisions;
+    sim.cull = config.cull;
+    StartPhysics(sim, sceneBodies, gravity, &pool, config.physicsThread);
+    WorldOrigin worldOrigin = { 0.0, 0.0, 0.0 }; // начало координат последнего снимка
+    std::vector<Vector3> drawPositions;          // интерполированные позиции кадра
+    // Подшаги физики и густота сетки под бюджет кадра
+    FrameGovernor governor = MakeFrameGovernor(config.frameBudgetMs, SUBSTEPS, config.governor);
+    float gridMs = 0.0f;
 
     // Состояние приложения
     bool is2D = false;
@@ -102,9 +125,13 @@ int main() {
     bool isCreateMode = false; // false = вращать камеру, true = создавать планеты
     
     float timeSpeed = 1.0f;
+    bool fastForward = false;  // перемотка: шаг прежний, шагов сколько успеем, кадров мало
     float newPlanetMass = 200.0f; // Текущая выбранная масса
     
-    int cameraTarget = -1; // -1 = центр
+    SlotHandle cameraTarget = NO_SLOT; // NO_SLOT = центр; ручка переживает слияния и перемотку
+    int restores = 0;        // сколько раз физика брала настройки из ключевого кадра
+    bool scrubbing = false;  // палец на полосе линии времени
+    float scrubPick = -1.0f; // куда просили перемотать в последний раз (доля полосы)
     
     PlanetBuilder builder = { false, {0,0,0}, {0,0,0} };
 
@@ -113,17 +140,57 @@ int main() {
         screenW = GetScreenWidth();
         screenH = GetScreenHeight();
 
+        // --- СНИМОК ФИЗИКИ ---
+        UpdatePhysicsInline(sim, GetFrameTime());
+        if (AcquireSlot(sim.snapshots)) {
+            // Физика перенесла начало координат (или сбросила сцену): камера следует за ним
+            const PhysicsSnapshot& fresh = ReadSlot(sim.snapshots);
+            Vector3 originShift = OriginDelta(fresh.origin, worldOrigin);
+            if (Vector3LengthSqr(originShift) > 0.0f) {
+                camera.target = Vector3Subtract(camera.target, originShift);
+                camera.position = Vector3Subtract(camera.position, originShift);
+                builder.startPos = Vector3Subtract(builder.startPos, originShift);
+                builder.endPos = Vector3Subtract(builder.endPos, originShift);
+            }
+            worldOrigin = fresh.origin;
+            // Перемотка вернула прошлые настройки: интерфейс и регулятор за ними
+            if (fresh.restores != restores) {
+                restores = fresh.restores;
+                gravity = fresh.gravity;
+                timeSpeed = fresh.timeSpeed;
+                governor.substeps = fresh.substeps;
+                governor.timeScale = fresh.timeScale;
+            }
+        }
+        const PhysicsSnapshot& view = ReadSlot(sim.snapshots);
+        const std::vector<Body>& bodies = view.bodies.dense;
+        InterpolatePositions(bodies, view.previous, SnapshotAlpha(view, PhysicsNow()), drawPositions);
+
         // --- ЛОГИКА КАМЕРЫ ---
-        if (cameraTarget != -1 && cameraTarget < (int)bodies.size()) {
-            camera.target = Vector3Lerp(camera.target, bodies[cameraTarget].position, 0.1f);
+        int followed = SlotIndex(view.bodies, cameraTarget);
+        if (followed >= 0) {
+            camera.target = Vector3Lerp(camera.target, drawPositions[followed], 0.1f);
         } else {
-            cameraTarget = -1;
-            camera.target = Vector3Lerp(camera.target, {0,0,0}, 0.1f);
+            cameraTarget = NO_SLOT;  // тело поглощено или сцену сбросили
+            Vector3 worldCenter = { (float)-worldOrigin.x, (float)-worldOrigin.y, (float)-worldOrigin.z };
+            camera.target = Vector3Lerp(camera.target, worldCenter, 0.1f);
+        }
+
+        // Плавающее начало координат: просим физику перенести его к камере,
+        // когда та далеко ушла; сдвиг придёт со следующим снимком
+        if (Vector3Length(camera.target) >= REBASE_DISTANCE) {
+            PhysicsCommand command = {};
+            command.type = CMD_REBASE;
+            command.anchor = camera.target;
+            command.origin = worldOrigin;
+            command.value = GRID_SPACING*BUDGET_MAX_GRID_STRIDE;  // кратно шагу сетки любой ступени
+            SendPhysicsCommand(sim, command);
         }
 
         // Вращаем камеру ТОЛЬКО если мы не в режиме создания и не тыкаем в интерфейс
         // Простая проверка: если палец в центре экрана (не на кнопках)
-        bool touchingUI = (GetMouseY() > screenH - 100) || (GetMouseY() < 80);
+        // (снизу — кнопки, скорость и полоса линии времени)
+        bool touchingUI = (GetMouseY() > screenH - 190) || (GetMouseY() < 80) || scrubbing;
         
         if (!is2D && !isCreateMode && !touchingUI) {
             UpdateCamera(&camera, CAMERA_ORBITAL);
@@ -148,41 +215,41 @@ int main() {
                     float radius = sqrt(newPlanetMass) / 4.0f;
                     if (radius < 1.0f) radius = 1.0f;
                     
-                    bodies.push_back({
+                    PhysicsCommand command = {};
+                    command.type = CMD_SPAWN;
+                    command.body = {
                         builder.startPos,
                         velocity,
                         newPlanetMass,
                         radius,
                         (newPlanetMass > 1000) ? RED : WHITE,
                         false
-                    });
+                    };
+                    command.origin = worldOrigin;
+                    SendPhysicsCommand(sim, command);
                 }
                 builder.active = false;
             }
         }
 
-        // --- ФИЗИКА ---
-        if (!isPaused) {
-            float dt = BASE_DT * timeSpeed;
-            for (int step = 0; step < SUBSTEPS; step++) {
-                for (size_t i = 0; i < bodies.size(); i++) {
-                    if (bodies[i].isFixed) continue;
-                    Vector3 totalForce = {0,0,0};
-                    for (size_t j = 0; j < bodies.size(); j++) {
-                        if (i==j) continue;
-                        Vector3 diff = Vector3Subtract(bodies[j].position, bodies[i].position);
-                        float distSq = Vector3LengthSqr(diff);
-                        float dist = sqrt(distSq);
-                        if (dist < bodies[i].radius + bodies[j].radius) dist = bodies[i].radius + bodies[j].radius;
-                        float force = (G * bodies[i].mass * bodies[j].mass) / distSq;
-                        totalForce = Vector3Add(totalForce, Vector3Scale(Vector3Normalize(diff), force));
-                    }
-                    bodies[i].velocity = Vector3Add(bodies[i].velocity, Vector3Scale(Vector3Scale(totalForce, 1.0f/bodies[i].mass), dt));
-                }
-                for (auto& b : bodies) {
-                    if (!b.isFixed) b.position = Vector3Add(b.position, Vector3Scale(b.velocity, dt));
-                }
-            }
+        // --- ВЫБОР РЕШАТЕЛЯ ---
+        // Новые настройки уходят физике; там же идёт сверка с прямой суммой
+        bool settingsChanged = false;
+        if (IsKeyPressed(KEY_B)) {
+            gravity.solver = (GravitySolver)((gravity.solver + 1) % SOLVER_COUNT);
+            settingsChanged = true;
+        }
+        if (IsKeyPressed(KEY_LEFT_BRACKET)) { gravity.theta = fmaxf(gravity.theta - 0.1f, 0.0f); settingsChanged = true; }
+        if (IsKeyPressed(KEY_RIGHT_BRACKET)) { gravity.theta = fminf(gravity.theta + 0.1f, 1.5f); settingsChanged = true; }
+        if (IsKeyPressed(KEY_I)) {
+            gravity.integrator = (Integrator)((gravity.integrator + 1) % INTEGRATOR_COUNT);
+            settingsChanged = true;
+        }
+        if (settingsChanged) {
+            PhysicsCommand command = {};
+            command.type = CMD_SETTINGS;
+            command.settings = gravity;
+            SendPhysicsCommand(sim, command);
         }
 
         // --- ОТРИСОВКА ---
@@ -191,24 +258,38 @@ int main() {
 
         BeginMode3D(camera);
             
-            // Сетка
-            int halfSize = GRID_SIZE / 2;
+            // Сетка (лёгкие тела её не прогибают — отбрасываем их один раз за кадр);
+            // регулятор может проредить её, сохраняя размах
+            double gridStart = GetTime();
+            heavyBodies.clear();
+            for (size_t i = 0; i < bodies.size(); i++) {
+                if (bodies[i].mass < 50.0f) continue;
+                heavyBodies.push_back(bodies[i]);
+                heavyBodies.back().position = drawPositions[i];
+            }
+            float spacing = GRID_SPACING * governor.gridStride;
+            int halfSize = GRID_SIZE / (2 * governor.gridStride);
             for (int x = -halfSize; x < halfSize; x++) {
                 for (int z = -halfSize; z < halfSize; z++) {
-                    float x1 = x * GRID_SPACING; float z1 = z * GRID_SPACING;
-                    float x2 = (x+1) * GRID_SPACING; float z2 = (z+1) * GRID_SPACING;
-                    float y1 = is2D ? -10 : GetSpacetimeCurve(x1, z1, bodies);
-                    float y2 = is2D ? -10 : GetSpacetimeCurve(x2, z1, bodies);
-                    float y3 = is2D ? -10 : GetSpacetimeCurve(x1, z2, bodies);
+                    float x1 = x * spacing; float z1 = z * spacing;
+                    float x2 = (x+1) * spacing; float z2 = (z+1) * spacing;
+                    float y1 = is2D ? -10 : GetSpacetimeCurve(x1, z1, heavyBodies);
+                    float y2 = is2D ? -10 : GetSpacetimeCurve(x2, z1, heavyBodies);
+                    float y3 = is2D ? -10 : GetSpacetimeCurve(x1, z2, heavyBodies);
                     
                     Color c = is2D ? DARKGRAY : Fade(SKYBLUE, 0.3f);
                     DrawLine3D({x1, y1, z1}, {x2, y2, z1}, c);
                     DrawLine3D({x1, y1, z1}, {x1, y3, z2}, c);
                 }
             }
+            gridMs = (float)((GetTime() - gridStart)*1000.0);
 
             // Тела
-            for (const auto& b : bodies) DrawSphere(b.position, b.radius, b.color);
+            if (bodies.size() < (size_t)LOWPOLY_BODIES) {
+                for (size_t i = 0; i < bodies.size(); i++) DrawSphere(drawPositions[i], bodies[i].radius, bodies[i].color);
+            } else {
+                for (size_t i = 0; i < bodies.size(); i++) DrawSphereEx(drawPositions[i], bodies[i].radius, 4, 4, bodies[i].color);
+            }
 
             // Линия прицеливания
             if (isCreateMode && builder.active) {
@@ -250,11 +331,11 @@ int main() {
         if (GuiButton({(float)btnW*1, (float)btnY, (float)btnW-5, (float)btnH}, is2D ? "2D" : "3D", DARKPURPLE)) {
             is2D = !is2D;
             if (is2D) {
-                camera.position = (Vector3){ 0.0f, 200.0f, 0.0f };
+                camera.position = Vector3Add(camera.target, (Vector3){ 0.0f, 200.0f, 0.0f });
                 camera.projection = CAMERA_ORTHOGRAPHIC;
                 camera.fovy = 100.0f;
             } else {
-                camera.position = (Vector3){ 0.0f, 150.0f, 120.0f };
+                camera.position = Vector3Add(camera.target, (Vector3){ 0.0f, 150.0f, 120.0f });
                 camera.projection = CAMERA_PERSPECTIVE;
                 camera.fovy = 45.0f;
             }
@@ -263,29 +344,128 @@ int main() {
         // Кнопка 3: Пауза
         if (GuiButton({(float)btnW*2, (float)btnY, (float)btnW-5, (float)btnH}, isPaused ? "| |" : ">", ORANGE)) {
             isPaused = !isPaused;
+            PhysicsCommand command = {};
+            command.type = CMD_PAUSE;
+            command.flag = isPaused;
+            SendPhysicsCommand(sim, command);
         }
 
         // Кнопка 4: Сброс
         if (GuiButton({(float)btnW*3, (float)btnY, (float)btnW-5, (float)btnH}, "RST", RED)) {
-            bodies.clear();
-            bodies.push_back({ {0,0,0}, {0,0,0}, 5000.0f, 10.0f, GOLD, true });
-            cameraTarget = -1;
+            // Начало координат вернётся в ноль со снимком, камера останется
+            // на месте в мировых координатах
+            PhysicsCommand command = {};
+            command.type = CMD_RESET;
+            SendPhysicsCommand(sim, command);
+            cameraTarget = NO_SLOT;
         }
 
         // Кнопка 5: Камера
         if (GuiButton({(float)btnW*4, (float)btnY, (float)btnW-5, (float)btnH}, "CAM", GRAY)) {
-            cameraTarget++;
-            if (cameraTarget >= (int)bodies.size()) cameraTarget = -1;
+            // Следующее тело после текущего; после последнего — снова центр
+            size_t next = (size_t)(SlotIndex(view.bodies, cameraTarget) + 1);
+            cameraTarget = (next < bodies.size()) ? SlotAt(view.bodies, next) : NO_SLOT;
+        }
+
+        // Линия времени (над скоростью): от самого старого ключевого кадра до
+        // самого дальнего посчитанного момента; тянем — перематываем
+        Rectangle timelineBar = { 20.0f, (float)btnY - 90, (float)screenW - 40, 30 };
+        double span = view.timelineEnd - view.timelineStart;
+        float played = (span > 0.0) ? (float)((view.time - view.timelineStart)/span) : 1.0f;
+        DrawRectangleRec(timelineBar, Fade(DARKGRAY, 0.8f));
+        DrawRectangle(timelineBar.x, timelineBar.y, timelineBar.width*played, timelineBar.height, Fade(SKYBLUE, 0.6f));
+        DrawText(TextFormat("t %.2f / %.2f", view.time, view.timelineEnd), timelineBar.x + 10, timelineBar.y + 5, 20, WHITE);
+        if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(GetMousePosition(), timelineBar)) scrubbing = true;
+        if (!IsMouseButtonDown(MOUSE_BUTTON_LEFT)) { scrubbing = false; scrubPick = -1.0f; }
+        if (scrubbing && span > 0.0) {
+            // Новая цель — только когда палец сдвинулся: каждая перемотка — до интервала шагов
+            float pick = Clamp((GetMouseX() - timelineBar.x)/timelineBar.width, 0.0f, 1.0f);
+            if (pick != scrubPick) {
+                scrubPick = pick;
+                PhysicsCommand command = {};
+                command.type = CMD_SEEK;
+                command.time = view.timelineStart + pick*span;
+                SendPhysicsCommand(sim, command);
+            }
         }
 
-        // Управление скоростью (над кнопками)
-        DrawText(TextFormat("Speed: %.1fx", timeSpeed), 20, btnY - 40, 20, YELLOW);
+        // Управление скоростью (над кнопками); темп — секунд симуляции за секунду
+        if (view.fastForward) {
+            DrawText(TextFormat("Fast forward: sim %.2f/s", view.simRate), 20, btnY - 40, 20, SKYBLUE);
+        } else {
+            DrawText(TextFormat("Speed: %.1fx  sim %.2f/s%s", timeSpeed, view.simRate, view.saturated ? " (lagging)" : ""), 20, btnY - 40, 20, view.saturated ? ORANGE : YELLOW);
+        }
+        bool oldFastForward = fastForward;
+        if (GuiButton({(float)screenW - 190, (float)btnY - 50, 60, 40}, ">>", fastForward ? SKYBLUE : DARKGRAY)) fastForward = !fastForward;
+        if (IsKeyPressed(KEY_F)) fastForward = !fastForward;
+        if (fastForward != oldFastForward) {
+            // Поток физики крутит шаги сам — отрисовке хватит нескольких кадров в секунду;
+            // без потока шаги идут внутри кадра, и ждать таймер незачем
+            SetTargetFPS(fastForward ? (sim.threaded ? FAST_FORWARD_FPS : 0) : 60);
+            PhysicsCommand command = {};
+            command.type = CMD_FAST_FORWARD;
+            command.flag = fastForward;
+            SendPhysicsCommand(sim, command);
+        }
+        float oldSpeed = timeSpeed;
         if (GuiButton({(float)screenW - 120, (float)btnY - 50, 50, 40}, "-", DARKGRAY)) timeSpeed *= 0.8f;
         if (GuiButton({(float)screenW - 60, (float)btnY - 50, 50, 40}, "+", DARKGRAY)) timeSpeed *= 1.2f;
+        if (timeSpeed != oldSpeed) {
+            PhysicsCommand command = {};
+            command.type = CMD_SPEED;
+            command.value = timeSpeed;
+            SendPhysicsCommand(sim, command);
+        }
 
         DrawFPS(20, 80);
+        // Решения регулятора: затраты против цели, подшаги, прореживание сетки, темп времени
+        if (governor.enabled) {
+            const char* slowed = (view.timeScale < 1.0f) ? TextFormat("  time %d%%", (int)(view.timeScale*100.0f)) : "";
+            DrawText(TextFormat("%.1f/%.0f ms  sub %d  grid /%d%s", governor.physicsMs + governor.gridMs, governor.targetMs,
+                view.substeps, governor.gridStride, slowed), 130, 80, 20, (view.timeScale < 1.0f) ? ORANGE : LIGHTGRAY);
+        }
+        // Настройки, с которыми физика реально считает (команда могла ещё не дойти)
+        const GravitySettings& active = view.gravity;
+        float solverError = view.solverError;
+        if (active.solver == SOLVER_BARNES_HUT) {
+            DrawText(TextFormat("N: %d  BH theta %.1f  err %s", (int)bodies.size(), active.theta, (solverError < 0.0f) ? "-" : TextFormat("%.2f%%", solverError*100.0f)), 20, 105, 20, LIGHTGRAY);
+        } else if (active.solver == SOLVER_PM) {
+            DrawText(TextFormat("N: %d  PM %d^3 %s", (int)bodies.size(), PmRoundGrid(active.pmGrid), PmBoundaryName(active.pmBoundary)), 20, 105, 20, LIGHTGRAY);
+        } else if (active.solver == SOLVER_FMM) {
+            DrawText(TextFormat("N: %d  FMM p%d theta %.1f  err %s", (int)bodies.size(), active.fmmOrder, active.theta, (solverError < 0.0f) ? "-" : TextFormat("%.2f%%", solverError*100.0f)), 20, 105, 20, LIGHTGRAY);
+        } else {
+            DrawText(TextFormat("N: %d  %s (%s)", (int)bodies.size(), GravitySolverName(active.solver), DirectKernelName()), 20, 105, 20, LIGHTGRAY);
+        }
+        float integratorDt = view.stepDt;
+        if (view.blockSteps) {
+            // Доля тел в блоке, блоков за тик, самый мелкий шаг
+            DrawText(TextFormat("%s dt %.4f  active %.1f%% x%d  min dt/%d", IntegratorName(active.integrator), integratorDt,
+                ActiveFraction(view.blocks)*100.0f, view.blocks.blocks, 1 << view.blocks.deepestLevel), 20, 130, 20, LIGHTGRAY);
+        } else if (view.encounterPairs > 0) {
+            DrawText(TextFormat("%s dt %.4f  pairs %d", IntegratorName(active.integrator), integratorDt, view.encounterPairs), 20, 130, 20, LIGHTGRAY);
+        } else {
+            DrawText(TextFormat("%s dt %.4f", IntegratorName(active.integrator), integratorDt), 20, 130, 20, LIGHTGRAY);
+        }
+        if (worldOrigin.x != 0.0 || worldOrigin.y != 0.0 || worldOrigin.z != 0.0) {
+            DrawText(TextFormat("Origin: %.0f %.0f %.0f", worldOrigin.x, worldOrigin.y, worldOrigin.z), 20, 155, 20, LIGHTGRAY);
+        }
         EndDrawing();
+
+        // --- БЮДЖЕТ КАДРА ---
+        // На паузе физика не считает — мерить нечего; при перемотке она нарочно
+        // занимает всё время
+        if (!isPaused && !fastForward && !view.fastForward && UpdateFrameGovernor(governor, view.physicsMs, gridMs)) {
+            if (governor.substeps != view.substeps || governor.timeScale != view.timeScale) {
+                PhysicsCommand command = {};
+                command.type = CMD_BUDGET;
+                command.substeps = governor.substeps;
+                command.value = governor.timeScale;
+                SendPhysicsCommand(sim, command);
+            }
+        }
     }
+    StopPhysics(sim);
+    StopThreadPool(pool);
     CloseWindow();
     return 0;
 }
@@ -0,0 +1,270 @@
+#ifndef PAIRWISE_KERNEL_H
+#define PAIRWISE_KERNEL_H
+
+#include "gravity.h"
+#include "body_store.h"
+#include "direct_kernel.h"
+#include "thread_pool.h"
+#include "cpu_features.h"
+#include <vector>
+#include <cmath>
+
+// --- СИММЕТРИЧНАЯ ПРЯМАЯ СУММА ---
+// Каждая пара считается один раз, телам достаются равные и противоположные вклады
+// (третий закон Ньютона). Тела режутся на плитки; пары плиток раздаются по
+// круговому расписанию: в одном раунде плитки не пересекаются, поэтому потоки
+// пишут в разные ячейки без блокировок, а порядок сложения для каждого тела
+// задаётся раундами и не зависит от числа потоков.
+// Закреплённые тела участвуют как источники; их ускорение считается, но
+// интегратор его не применяет.
+
+const size_t PAIR_TILE = 128;  // кратно BODY_STORE_WIDTH
+
+struct PairwiseBuffers {
+    AlignedFloats ax, ay, az;  // ускорения без множителя G
+    std::vector<int> schedule; // пары плиток по раундам: roundStart[r]..roundStart[r+1]
+    std::vector<int> roundStart;
+    int scheduledTiles = -1;
+};
+
+// Круговое расписание (метод многоугольника) для tileCount плиток
+inline void BuildPairSchedule(PairwiseBuffers& buf, int tileCount) {
+    buf.schedule.clear();
+    buf.roundStart.clear();
+    buf.scheduledTiles = tileCount;
+
+    // Раунд 0: каждая плитка сама с собой
+    buf.roundStart.push_back(0);
+    for (int t = 0; t < tileCount; t++) { buf.schedule.push_back(t); buf.schedule.push_back(t); }
+
+    int n = (tileCount % 2 == 0) ? tileCount : tileCount + 1;  // с фиктивной плиткой
+    for (int r = 0; r < n - 1; r++) {
+        buf.roundStart.push_back((int)buf.schedule.size()/2);
+        for (int k = 0; k < n/2; k++) {
+            int a = (k == 0) ? n - 1 : (r + k) % (n - 1);
+            int b = (r - k + n - 1) % (n - 1);
+            if (a >= tileCount || b >= tileCount) continue;
+            buf.schedule.push_back(a);
+            buf.schedule.push_back(b);
+        }
+    }
+    buf.roundStart.push_back((int)buf.schedule.size()/2);
+}
+
+// Взаимодействия внутри одной плитки: только j > i
+inline void PairTileSelf(const BodyStore& s, PairwiseBuffers& buf, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        float xi = s.x[i], yi = s.y[i], zi = s.z[i], mi = s.m[i];
+        float ax = 0.0f, ay = 0.0f, az = 0.0f;
+        for (size_t j = i + 1; j < end; j++) {
+            float dx = s.x[j] - xi;
+            float dy = s.y[j] - yi;
+            float dz = s.z[j] - zi;
+            float distSq = dx*dx + dy*dy + dz*dz;
+            if (distSq <= 0.0f) continue;
+            float inv = 1.0f/sqrtf(distSq);
+            float invCube = inv*inv*inv;
+            float si = s.m[j]*invCube;
+            float sj = mi*invCube;
+            ax += dx*si; ay += dy*si; az += dz*si;
+            buf.ax[j] -= dx*sj; buf.ay[j] -= dy*sj; buf.az[j] -= dz*sj;
+        }
+        buf.ax[i] += ax; buf.ay[i] += ay; buf.az[i] += az;
+    }
+}
+
+inline void PairTilesScalar(const BodyStore& s, PairwiseBuffers& buf, size_t beginA, size_t beginB) {
+    for (size_t i = beginA; i < beginA + PAIR_TILE; i++) {
+        float xi = s.x[i], yi = s.y[i], zi = s.z[i], mi = s.m[i];
+        float ax = 0.0f, ay = 0.0f, az = 0.0f;
+        for (size_t j = beginB; j < beginB + PAIR_TILE; j++) {
+            float dx = s.x[j] - xi;
+            float dy = s.y[j] - yi;
+            float dz = s.z[j] - zi;
+            float distSq = dx*dx + dy*dy + dz*dz;
+            if (distSq <= 0.0f) continue;
+            float inv = 1.0f/sqrtf(distSq);
+            float invCube = inv*inv*inv;
+            float si = s.m[j]*invCube;
+            float sj = mi*invCube;
+            ax += dx*si; ay += dy*si; az += dz*si;
+            buf.ax[j] -= dx*sj; buf.ay[j] -= dy*sj; buf.az[j] -= dz*sj;
+        }
+        buf.ax[i] += ax; buf.ay[i] += ay; buf.az[i] += az;
+    }
+}
+
+// См. direct_kernel.h: ложные предупреждения заголовков AVX-512 в GCC 12
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wuninitialized"
+    #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#if defined(GRAVITY_X86)
+GRAVITY_TARGET("sse2")
+inline void PairTilesSse(const BodyStore& s, PairwiseBuffers& buf, size_t beginA, size_t beginB) {
+    __m128 zero = _mm_setzero_ps();
+    for (size_t i = beginA; i < beginA + PAIR_TILE; i++) {
+        __m128 xi = _mm_set1_ps(s.x[i]), yi = _mm_set1_ps(s.y[i]), zi = _mm_set1_ps(s.z[i]), mi = _mm_set1_ps(s.m[i]);
+        __m128 ax = _mm_setzero_ps(), ay = _mm_setzero_ps(), az = _mm_setzero_ps();
+        for (size_t j = beginB; j < beginB + PAIR_TILE; j += 4) {
+            __m128 dx = _mm_sub_ps(_mm_load_ps(&s.x[j]), xi);
+            __m128 dy = _mm_sub_ps(_mm_load_ps(&s.y[j]), yi);
+            __m128 dz = _mm_sub_ps(_mm_load_ps(&s.z[j]), zi);
+            __m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            __m128 mask = _mm_cmpgt_ps(distSq, zero);
+            __m128 inv = RsqrtSse(distSq);
+            __m128 invCube = _mm_and_ps(_mm_mul_ps(inv, _mm_mul_ps(inv, inv)), mask);
+            __m128 si = _mm_mul_ps(_mm_load_ps(&s.m[j]), invCube);
+            __m128 sj = _mm_mul_ps(mi, invCube);
+            ax = _mm_add_ps(ax, _mm_mul_ps(dx, si));
+            ay = _mm_add_ps(ay, _mm_mul_ps(dy, si));
+            az = _mm_add_ps(az, _mm_mul_ps(dz, si));
+            _mm_store_ps(&buf.ax[j], _mm_sub_ps(_mm_load_ps(&buf.ax[j]), _mm_mul_ps(dx, sj)));
+            _mm_store_ps(&buf.ay[j], _mm_sub_ps(_mm_load_ps(&buf.ay[j]), _mm_mul_ps(dy, sj)));
+            _mm_store_ps(&buf.az[j], _mm_sub_ps(_mm_load_ps(&buf.az[j]), _mm_mul_ps(dz, sj)));
+        }
+        buf.ax[i] += HorizontalSum128(ax); buf.ay[i] += HorizontalSum128(ay); buf.az[i] += HorizontalSum128(az);
+    }
+}
+
+GRAVITY_TARGET("avx2")
+inline void PairTilesAvx2(const BodyStore& s, PairwiseBuffers& buf, size_t beginA, size_t beginB) {
+    __m256 zero = _mm256_setzero_ps();
+    for (size_t i = beginA; i < beginA + PAIR_TILE; i++) {
+        __m256 xi = _mm256_set1_ps(s.x[i]), yi = _mm256_set1_ps(s.y[i]), zi = _mm256_set1_ps(s.z[i]), mi = _mm256_set1_ps(s.m[i]);
+        __m256 ax = _mm256_setzero_ps(), ay = _mm256_setzero_ps(), az = _mm256_setzero_ps();
+        for (size_t j = beginB; j < beginB + PAIR_TILE; j += 8) {
+            __m256 dx = _mm256_sub_ps(_mm256_load_ps(&s.x[j]), xi);
+            __m256 dy = _mm256_sub_ps(_mm256_load_ps(&s.y[j]), yi);
+            __m256 dz = _mm256_sub_ps(_mm256_load_ps(&s.z[j]), zi);
+            __m256 distSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+            __m256 mask = _mm256_cmp_ps(distSq, zero, _CMP_GT_OQ);
+            __m256 inv = RsqrtAvx2(distSq);
+            __m256 invCube = _mm256_and_ps(_mm256_mul_ps(inv, _mm256_mul_ps(inv, inv)), mask);
+            __m256 si = _mm256_mul_ps(_mm256_load_ps(&s.m[j]), invCube);
+            __m256 sj = _mm256_mul_ps(mi, invCube);
+            ax = _mm256_add_ps(ax, _mm256_mul_ps(dx, si));
+            ay = _mm256_add_ps(ay, _mm256_mul_ps(dy, si));
+            az = _mm256_add_ps(az, _mm256_mul_ps(dz, si));
+            _mm256_store_ps(&buf.ax[j], _mm256_sub_ps(_mm256_load_ps(&buf.ax[j]), _mm256_mul_ps(dx, sj)));
+            _mm256_store_ps(&buf.ay[j], _mm256_sub_ps(_mm256_load_ps(&buf.ay[j]), _mm256_mul_ps(dy, sj)));
+            _mm256_store_ps(&buf.az[j], _mm256_sub_ps(_mm256_load_ps(&buf.az[j]), _mm256_mul_ps(dz, sj)));
+        }
+        buf.ax[i] += HorizontalSum256(ax); buf.ay[i] += HorizontalSum256(ay); buf.az[i] += HorizontalSum256(az);
+    }
+}
+
+GRAVITY_TARGET("avx512f")
+inline void PairTilesAvx512(const BodyStore& s, PairwiseBuffers& buf, size_t beginA, size_t beginB) {
+    __m512 zero = _mm512_setzero_ps();
+    for (size_t i = beginA; i < beginA + PAIR_TILE; i++) {
+        __m512 xi = _mm512_set1_ps(s.x[i]), yi = _mm512_set1_ps(s.y[i]), zi = _mm512_set1_ps(s.z[i]), mi = _mm512_set1_ps(s.m[i]);
+        __m512 ax = _mm512_setzero_ps(), ay = _mm512_setzero_ps(), az = _mm512_setzero_ps();
+        for (size_t j = beginB; j < beginB + PAIR_TILE; j += 16) {
+            __m512 dx = _mm512_sub_ps(_mm512_load_ps(&s.x[j]), xi);
+            __m512 dy = _mm512_sub_ps(_mm512_load_ps(&s.y[j]), yi);
+            __m512 dz = _mm512_sub_ps(_mm512_load_ps(&s.z[j]), zi);
+            __m512 distSq = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy)), _mm512_mul_ps(dz, dz));
+            __mmask16 mask = _mm512_cmp_ps_mask(distSq, zero, _CMP_GT_OQ);
+            __m512 inv = RsqrtAvx512(distSq);
+            __m512 invCube = _mm512_maskz_mul_ps(mask, inv, _mm512_mul_ps(inv, inv));
+            __m512 si = _mm512_mul_ps(_mm512_load_ps(&s.m[j]), invCube);
+            __m512 sj = _mm512_mul_ps(mi, invCube);
+            ax = _mm512_add_ps(ax, _mm512_mul_ps(dx, si));
+            ay = _mm512_add_ps(ay, _mm512_mul_ps(dy, si));
+            az = _mm512_add_ps(az, _mm512_mul_ps(dz, si));
+            _mm512_store_ps(&buf.ax[j], _mm512_sub_ps(_mm512_load_ps(&buf.ax[j]), _mm512_mul_ps(dx, sj)));
+            _mm512_store_ps(&buf.ay[j], _mm512_sub_ps(_mm512_load_ps(&buf.ay[j]), _mm512_mul_ps(dy, sj)));
+            _mm512_store_ps(&buf.az[j], _mm512_sub_ps(_mm512_load_ps(&buf.az[j]), _mm512_mul_ps(dz, sj)));
+        }
+        buf.ax[i] += HorizontalSum512(ax); buf.ay[i] += HorizontalSum512(ay); buf.az[i] += HorizontalSum512(az);
+    }
+}
+#endif
+
+#if defined(GRAVITY_NEON)
+inline void PairTilesNeon(const BodyStore& s, PairwiseBuffers& buf, size_t beginA, size_t beginB) {
+    float32x4_t zero = vdupq_n_f32(0.0f);
+    for (size_t i = beginA; i < beginA + PAIR_TILE; i++) {
+        float32x4_t xi = vdupq_n_f32(s.x[i]), yi = vdupq_n_f32(s.y[i]), zi = vdupq_n_f32(s.z[i]), mi = vdupq_n_f32(s.m[i]);
+        float32x4_t ax = zero, ay = zero, az = zero;
+        for (size_t j = beginB; j < beginB + PAIR_TILE; j += 4) {
+            float32x4_t dx = vsubq_f32(vld1q_f32(&s.x[j]), xi);
+            float32x4_t dy = vsubq_f32(vld1q_f32(&s.y[j]), yi);
+            float32x4_t dz = vsubq_f32(vld1q_f32(&s.z[j]), zi);
+            float32x4_t distSq = vaddq_f32(vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy)), vmulq_f32(dz, dz));
+            uint32x4_t mask = vcgtq_f32(distSq, zero);
+            float32x4_t inv = RsqrtNeon(distSq);
+            float32x4_t invCube = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(vmulq_f32(inv, vmulq_f32(inv, inv))), mask));
+            float32x4_t si = vmulq_f32(vld1q_f32(&s.m[j]), invCube);
+            float32x4_t sj = vmulq_f32(mi, invCube);
+            ax = vaddq_f32(ax, vmulq_f32(dx, si));
+            ay = vaddq_f32(ay, vmulq_f32(dy, si));
+            az = vaddq_f32(az, vmulq_f32(dz, si));
+            vst1q_f32(&buf.ax[j], vsubq_f32(vld1q_f32(&buf.ax[j]), vmulq_f32(dx, sj)));
+            vst1q_f32(&buf.ay[j], vsubq_f32(vld1q_f32(&buf.ay[j]), vmulq_f32(dy, sj)));
+            vst1q_f32(&buf.az[j], vsubq_f32(vld1q_f32(&buf.az[j]), vmulq_f32(dz, sj)));
+        }
+        buf.ax[i] += HorizontalSumNeon(ax); buf.ay[i] += HorizontalSumNeon(ay); buf.az[i] += HorizontalSumNeon(az);
+    }
+}
+#endif
+
+inline void PairTiles(GravityIsa isa, const BodyStore& s, PairwiseBuffers& buf, size_t beginA, size_t beginB) {
+    switch (isa) {
+#if defined(GRAVITY_X86)
+        case ISA_AVX512: PairTilesAvx512(s, buf, beginA, beginB); break;
+        case ISA_AVX2: PairTilesAvx2(s, buf, beginA, beginB); break;
+        case ISA_SSE2: PairTilesSse(s, buf, beginA, beginB); break;
+#endif
+#if defined(GRAVITY_NEON)
+        case ISA_NEON: PairTilesNeon(s, buf, beginA, beginB); break;
+#endif
+        default: PairTilesScalar(s, buf, beginA, beginB); break;
+    }
+}
+
+inline void ComputeAccelerationsPairwise(const std::vector<Body>& bodies, std::vector<Vector3>& acc, BodyStore& store, PairwiseBuffers& buf, ThreadPool* pool) {
+    PackBodies(bodies, store);
+    acc.assign(bodies.size(), {0,0,0});
+    if (bodies.empty()) return;
+
+    // Дополняем до целых плиток (нулевые массы)
+    size_t tiled = (store.count + PAIR_TILE - 1) / PAIR_TILE * PAIR_TILE;
+    AlignedFloats* arrays[] = { &store.x, &store.y, &store.z, &store.m };
+    for (AlignedFloats* a : arrays) a->resize(tiled, 0.0f);
+    store.padded = tiled;
+    buf.ax.assign(tiled, 0.0f);
+    buf.ay.assign(tiled, 0.0f);
+    buf.az.assign(tiled, 0.0f);
+
+    int tileCount = (int)(tiled / PAIR_TILE);
+    GravityIsa isa = ActiveIsa();
+    if (buf.scheduledTiles != tileCount) BuildPairSchedule(buf, tileCount);
+
+    for (size_t r = 0; r + 1 < buf.roundStart.size(); r++) {
+        int first = buf.roundStart[r];
+        int count = buf.roundStart[r + 1] - first;
+        ParallelFor(pool, (size_t)count, 1, [&](size_t begin, size_t end) {
+            for (size_t p = begin; p < end; p++) {
+                int a = buf.schedule[2*(first + p)];
+                int b = buf.schedule[2*(first + p) + 1];
+                if (a == b) PairTileSelf(store, buf, a*PAIR_TILE, (a + 1)*PAIR_TILE);
+                else PairTiles(isa, store, buf, a*PAIR_TILE, b*PAIR_TILE);
+            }
+        });
+    }
+
+    for (size_t i = 0; i < store.count; i++) {
+        if (store.fixed[i]) continue;
+        acc[i] = { G*buf.ax[i], G*buf.ay[i], G*buf.az[i] };
+    }
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic pop
+#endif
+
+#endif
@@ -0,0 +1,395 @@
+#ifndef PHYSICS_H
+#define PHYSICS_H
+
+#include "gravity.h"
+#include "barnes_hut.h"
+#include "body_store.h"
+#include "direct_kernel.h"
+#include "pairwise_kernel.h"
+#include "fmm.h"
+#include "pm_solver.h"
+#include "floating_origin.h"
+#include "block_steps.h"
+#include "hermite.h"
+#include "kepler.h"
+#include "encounters.h"
+#include <vector>
+
+// --- ФИЗИКА ---
+// Leapfrog с индивидуальными шагами: ускорения начала шага каждого тела
+struct AdaptiveLeapfrog {
+    BlockScheduler blocks;
+    std::vector<Vector3> acc;
+    bool valid = false;
+    double outer = 0.0;  // длина внешнего шага, под которую выбраны шаги тел
+};
+
+// Wisdom-Holman: центральное тело, длина подшага и толчки без вклада центра
+struct WisdomHolman {
+    int central = -1;          // самое тяжёлое закреплённое тело; -1 = нет
+    double maxStep = 0.0;      // доля кратчайшего периода
+    std::vector<Body> others;  // все тела, кроме центра
+    std::vector<Vector3> acc;  // ускорения от others, по индексам bodies
+    std::vector<Vector3> othersAcc;
+    std::vector<double> velocity;  // скорости в double: float на каждом шаге копил бы ошибку
+    bool valid = false;
+};
+
+// Рабочие буферы решателей переживают кадр, чтобы не выделять память на каждом шаге
+struct GravityWorkspace {
+    std::vector<Vector3> accelerations;
+    std::vector<Vector3> reference;
+    Octree octree;
+    BodyStore store;
+    DirectTiling tiling = ChooseDirectTiling(DetectCacheSizes());
+    DirectBuffers direct;
+    PairwiseBuffers pairwise;
+    FmmSolver fmm;
+    PmSolver pm;
+    std::vector<Vector3> leapfrogAcc;  // ускорения конца прошлого шага leapfrog
+    bool leapfrogValid = false;
+    EncounterState encounters;  // тесные пары leapfrog
+    AdaptiveLeapfrog adaptive;
+    HermiteState hermite;  // double-состояние тел между внешними шагами Эрмита
+    WisdomHolman wh;
+    ThreadPool* pool = nullptr;  // nullptr = считать в вызывающем потоке
+};
+
+inline void ComputeAccelerations(const std::vector<Body>& bodies, std::vector<Vector3>& acc, const GravitySettings& settings, GravityWorkspace& ws) {
+    switch (settings.solver) {
+        case SOLVER_BARNES_HUT: ComputeAccelerationsBarnesHut(bodies, acc, ws.octree, settings.theta, settings.leafSize, ws.pool); break;
+        case SOLVER_FMM: ComputeAccelerationsFmm(bodies, acc, ws.octree, ws.fmm, settings.theta, settings.fmmOrder, settings.fmmLeafSize, ws.pool); break;
+        case SOLVER_PM: ComputeAccelerationsPm(bodies, acc, ws.pm, settings.pmGrid, settings.pmBoundary, settings.pmBoxSize, ws.pool); break;
+        case SOLVER_PAIRWISE: ComputeAccelerationsPairwise(bodies, acc, ws.store, ws.pairwise, ws.pool); break;
+        default:
+            if (settings.tiledDirect) ComputeAccelerationsDirect(bodies, acc, ws.store, ws.tiling, ws.direct, ws.pool);
+            else ComputeAccelerationsDirectUntiled(bodies, acc, ws.store, ws.pool);
+            break;
+    }
+}
+
+// Сравнивает выбранный решатель с прямой суммой; возвращает макс. относительную ошибку
+inline float MeasureSolverError(const std::vector<Body>& bodies, const GravitySettings& settings, GravityWorkspace& ws) {
+    ComputeAccelerations(bodies, ws.accelerations, settings, ws);
+    ComputeAccelerationsReference(bodies, ws.reference);
+    return MaxRelativeError(bodies, ws.accelerations, ws.reference);
+}
+
+const float BASE_DT = 0.0005f;  // шаг Эйлера при скорости 1x
+
+// Во сколько раз длиннее шаг схемы, чем базовый шаг Эйлера. Leapfrog на
+// шаге в 4 раза крупнее уходит по орбите так же, как Эйлер на базовом
+// (BenchIntegrators, e = 0.5: 4.6e-3 против 4.8e-3 полуоси), а энергию
+// держит в ~10 раз точнее
+const int LEAPFROG_STRIDE = 4;
+// У схем с блочными шагами это внешний шаг: внутри него тела идут своими шагами
+const int ADAPTIVE_STRIDE = 8;
+const int HERMITE_STRIDE = 8;
+// Шаг Wisdom-Holman — 1/WH_STEPS_PER_ORBIT кратчайшего периода вокруг
+// центра (WisdomHolmanStep): физика берёт его вместо BASE_DT и растягивает
+// под него тик. WH_STRIDE — шаг, пока центра нет; шаг длиннее текущей доли
+// периода (орбита с тех пор укоротилась) дробится на подшаги.
+const int WH_STRIDE = 16;
+const int WH_STEPS_PER_ORBIT = 20;
+
+inline int IntegratorStride(Integrator integrator) {
+    switch (integrator) {
+        case INTEGRATOR_LEAPFROG: return LEAPFROG_STRIDE;
+        case INTEGRATOR_ADAPTIVE: return ADAPTIVE_STRIDE;
+        case INTEGRATOR_HERMITE: return HERMITE_STRIDE;
+        case INTEGRATOR_WISDOM_HOLMAN: return WH_STRIDE;
+        default: return 1;
+    }
+}
+
+// Кэши ускорений leapfrog и состояние Эрмита устарели: тела добавлены,
+// убраны или сменился решатель
+inline void InvalidateAccelerationCache(GravityWorkspace& ws) {
+    ws.leapfrogValid = false;
+    ws.adaptive.valid = false;
+    ws.hermite.valid = false;
+    ws.wh.valid = false;
+    ws.encounters.pairs.clear();
+}
+
+// Статистика блочных шагов выбранной схемы; nullptr — у схемы общий шаг
+inline const BlockStats* IntegratorBlockStats(const GravityWorkspace& ws, Integrator integrator) {
+    switch (integrator) {
+        case INTEGRATOR_ADAPTIVE: return &ws.adaptive.blocks.stats;
+        case INTEGRATOR_HERMITE: return &ws.hermite.blocks.stats;
+        default: return nullptr;
+    }
+}
+
+// Один подшаг: полунеявный Эйлер (сначала скорости, потом позиции с компенсацией)
+inline void StepEuler(std::vector<Body>& bodies, float dt, const GravitySettings& settings, GravityWorkspace& ws) {
+    ComputeAccelerations(bodies, ws.accelerations, settings, ws);
+    for (size_t i = 0; i < bodies.size(); i++) {
+        if (bodies[i].isFixed) continue;
+        bodies[i].velocity = Vector3Add(bodies[i].velocity, Vector3Scale(ws.accelerations[i], dt));
+    }
+    for (auto& b : bodies) {
+        if (!b.isFixed) DriftBody(b, dt);
+    }
+}
+
+// Ускорения для leapfrog: тесные пары решатель видит одной точкой
+inline void LeapfrogAccelerations(const std::vector<Body>& bodies, const GravitySettings& settings, GravityWorkspace& ws) {
+    EncounterState& es = ws.encounters;
+    if (es.pairs.empty()) {
+        ComputeAccelerations(bodies, ws.leapfrogAcc, settings, ws);
+        return;
+    }
+    ComputeAccelerations(ReduceEncounterPairs(bodies, es), es.reducedAcc, settings, ws);
+    ExpandEncounterAccelerations(es, ws.leapfrogAcc);
+}
+
+// Kick-drift-kick. Ускорения конца шага — они же начало следующего, поэтому
+// на шаг приходится одно вычисление сил, как и у Эйлера. Члены тесной пары
+// получают одинаковый толчок (толкается центр масс), а дрейфуют по Кеплеру.
+inline void StepLeapfrog(std::vector<Body>& bodies, float dt, const GravitySettings& settings, GravityWorkspace& ws) {
+    EncounterState& es = ws.encounters;
+    if (settings.regularize) {
+        // Смена пар не стоит лишнего вычисления сил: кэш поправляется
+        if (FindEncounterPairs(bodies, dt, es) && ws.leapfrogValid) ws.leapfrogValid = RepairEncounterAccelerations(bodies, es, ws.leapfrogAcc);
+    } else if (!es.pairs.empty()) {
+        es.pairs.clear();
+        ws.leapfrogValid = false;
+    }
+    if (!ws.leapfrogValid || ws.leapfrogAcc.size() != bodies.size()) {
+        LeapfrogAccelerations(bodies, settings, ws);
+        ws.leapfrogValid = true;
+    }
+    float half = 0.5f*dt;
+    for (size_t i = 0; i < bodies.size(); i++) {
+        if (bodies[i].isFixed) continue;
+        bodies[i].velocity = Vector3Add(bodies[i].velocity, Vector3Scale(ws.leapfrogAcc[i], half));
+        if (es.pairs.empty() || es.partner[i] < 0) DriftBody(bodies[i], dt);
+    }
+    for (const EncounterPair& p : es.pairs) DriftEncounterPair(bodies[p.a], bodies[p.b], dt);
+    LeapfrogAccelerations(bodies, settings, ws);
+    for (size_t i = 0; i < bodies.size(); i++) {
+        if (bodies[i].isFixed) continue;
+        bodies[i].velocity = Vector3Add(bodies[i].velocity, Vector3Scale(ws.leapfrogAcc[i], half));
+    }
+}
+
+// --- ИНДИВИДУАЛЬНЫЕ ШАГИ ---
+// Каждое тело идёт своим kick-drift-kick с шагом из планировщика блоков.
+// Шаг следует за |a|/|da/dt|: производная ускорения берётся из разности
+// ускорений на концах прошлого шага, первый шаг — из рывка прямой суммы.
+// В блоке все тела дрейфуют до его времени, а силы прямой суммой (векторное
+// ядро по строкам) считаются только на активные. Тело на широкой орбите
+// обновляется раз за внешний шаг, тесная пара — столько раз, сколько нужно ей.
+const double ADAPTIVE_ETA = 0.03;
+
+// Рывок на тело i (для выбора первого шага)
+inline double BodyJerk(const std::vector<Body>& bodies, const std::vector<double>& pos, size_t i) {
+    double jerk[3] = { 0.0, 0.0, 0.0 };
+    for (size_t k = 0; k < bodies.size(); k++) {
+        if (k == i) continue;
+        double dr[3], dv[3];
+        for (int c = 0; c < 3; c++) dr[c] = pos[3*k + c] - pos[3*i + c];
+        dv[0] = (double)bodies[k].velocity.x - bodies[i].velocity.x;
+        dv[1] = (double)bodies[k].velocity.y - bodies[i].velocity.y;
+        dv[2] = (double)bodies[k].velocity.z - bodies[i].velocity.z;
+        double r2 = Dot3(dr, dr);
+        if (r2 <= 0.0) continue;
+        double mr3 = bodies[k].mass/(r2*sqrt(r2));
+        double rv = 3.0*Dot3(dr, dv)/r2;
+        for (int c = 0; c < 3; c++) jerk[c] += mr3*(dv[c] - rv*dr[c]);
+    }
+    return G*sqrt(Dot3(jerk, jerk));
+}
+
+inline void InitAdaptiveLeapfrog(const std::vector<Body>& bodies, double outer, GravityWorkspace& ws) {
+    AdaptiveLeapfrog& al = ws.adaptive;
+    size_t n = bodies.size();
+    std::vector<unsigned char> fixed(n);
+    std::vector<double> pos(3*n);
+    for (size_t i = 0; i < n; i++) {
+        fixed[i] = bodies[i].isFixed ? 1 : 0;
+        BodyOffset(bodies[i], &pos[3*i]);
+    }
+    ResetBlockScheduler(al.blocks, fixed);
+    PackBodies(bodies, ws.store);
+    al.acc.assign(n, {0,0,0});
+    double quantum = outer/(double)BLOCK_FULL;
+    ParallelFor(ws.pool, n, 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if (fixed[i]) continue;
+            al.acc[i] = DirectAcceleration(ws.store, i);
+            double jerk = BodyJerk(bodies, pos, i);
+            double want = (jerk > 0.0) ? ADAPTIVE_ETA*Vector3Length(al.acc[i])/jerk : outer;
+            al.blocks.step[i] = QuantizeBlockStep(want, quantum, 0);
+        }
+    });
+    al.outer = outer;
+    al.valid = true;
+}
+
+inline void StepAdaptiveLeapfrog(std::vector<Body>& bodies, float outerStep, GravityWorkspace& ws) {
+    AdaptiveLeapfrog& al = ws.adaptive;
+    double outer = outerStep;
+    if (!al.valid || al.acc.size() != bodies.size() || al.outer != outer) InitAdaptiveLeapfrog(bodies, outer, ws);
+    double quantum = outer/(double)BLOCK_FULL;
+    BlockScheduler& sched = al.blocks;
+    BeginBlockStats(sched);
+
+    uint64_t now = 0;
+    for (;;) {
+        // Первый полупинок телам, которые начинают шаг
+        for (size_t i = 0; i < bodies.size(); i++) {
+            if (sched.fixed[i] || sched.time[i] != now) continue;
+            bodies[i].velocity = Vector3Add(bodies[i].velocity, Vector3Scale(al.acc[i], (float)(0.5*sched.step[i]*quantum)));
+        }
+        uint64_t next = CollectActiveBodies(sched);
+        if (sched.active.empty()) break;  // одни закреплённые тела
+        float drift = (float)((next - now)*quantum);
+        for (size_t i = 0; i < bodies.size(); i++) {
+            if (!sched.fixed[i]) DriftBody(bodies[i], drift);
+        }
+        now = next;
+
+        // Второй полупинок активным и новый шаг по изменению ускорения
+        PackBodies(bodies, ws.store);
+        ParallelFor(ws.pool, sched.active.size(), 16, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; k++) {
+                int i = sched.active[k];
+                Vector3 a1 = DirectAcceleration(ws.store, i);
+                double step = sched.step[i]*quantum;
+                bodies[i].velocity = Vector3Add(bodies[i].velocity, Vector3Scale(a1, (float)(0.5*step)));
+                double change = Vector3Length(Vector3Subtract(a1, al.acc[i]));
+                double want = (change > 0.0) ? ADAPTIVE_ETA*Vector3Length(a1)*step/change : outer;
+                al.acc[i] = a1;
+                sched.time[i] = next;
+                AdaptBlockStep(sched, i, want, quantum);
+            }
+        });
+        FinishBlock(sched);
+        if (next == BLOCK_FULL) break;
+    }
+    EndBlockStep(sched);
+}
+
+// --- WISDOM-HOLMAN ---
+// Гамильтониан делится на кеплеровы орбиты вокруг центрального тела и
+// взаимодействие всех остальных. Центр закреплён, поэтому гелиоцентрические
+// координаты инерциальны и косвенного члена нет. Шаг: полтолчка от
+// взаимодействий, точный кеплеров дрейф, полтолчок. Ошибка пропорциональна
+// отношению масс планет к звезде, поэтому шаг — доля периода, а не BASE_DT.
+// Взаимодействия считает выбранный решатель по списку без центра.
+// Без закреплённого тела схема сводится к обычному leapfrog.
+
+// Центр — самое тяжёлое закреплённое тело; -1 — нет
+inline int WisdomHolmanCentral(const std::vector<Body>& bodies) {
+    int central = -1;
+    for (size_t i = 0; i < bodies.size(); i++) {
+        if (bodies[i].isFixed && (central < 0 || bodies[i].mass > bodies[central].mass)) central = (int)i;
+    }
+    return central;
+}
+
+// Доля кратчайшего периода вокруг центра; 0 — центра или связанных орбит нет
+inline double WisdomHolmanStep(const std::vector<Body>& bodies) {
+    int central = WisdomHolmanCentral(bodies);
+    if (central < 0) return 0.0;
+    double step = 0.0;
+    double gm = (double)G*bodies[central].mass;
+    double c[3];
+    BodyOffset(bodies[central], c);
+    for (const Body& b : bodies) {
+        if (b.isFixed) continue;
+        double r[3], v[3] = { b.velocity.x, b.velocity.y, b.velocity.z };
+        BodyOffset(b, r);
+        for (int k = 0; k < 3; k++) r[k] -= c[k];
+        double period = KeplerPeriod(gm, r, v);
+        if (period > 0.0 && (step == 0.0 || period/WH_STEPS_PER_ORBIT < step)) step = period/WH_STEPS_PER_ORBIT;
+    }
+    return step;
+}
+
+inline void InitWisdomHolman(const std::vector<Body>& bodies, WisdomHolman& wh) {
+    wh.central = WisdomHolmanCentral(bodies);
+    wh.maxStep = WisdomHolmanStep(bodies);
+    wh.velocity.resize(3*bodies.size());
+    for (size_t i = 0; i < bodies.size(); i++) {
+        wh.velocity[3*i] = bodies[i].velocity.x;
+        wh.velocity[3*i + 1] = bodies[i].velocity.y;
+        wh.velocity[3*i + 2] = bodies[i].velocity.z;
+    }
+    wh.valid = true;
+}
+
+// Ускорения от всех тел, кроме центрального
+inline void WisdomHolmanKicks(const std::vector<Body>& bodies, const GravitySettings& settings, GravityWorkspace& ws) {
+    WisdomHolman& wh = ws.wh;
+    wh.others.clear();
+    for (size_t i = 0; i < bodies.size(); i++) if ((int)i != wh.central) wh.others.push_back(bodies[i]);
+    ComputeAccelerations(wh.others, wh.othersAcc, settings, ws);
+    wh.acc.assign(bodies.size(), {0,0,0});
+    for (size_t k = 0; k < wh.others.size(); k++) wh.acc[((int)k < wh.central) ? k : k + 1] = wh.othersAcc[k];
+}
+
+inline void KeplerDriftBodies(std::vector<Body>& bodies, WisdomHolman& wh, double dt) {
+    const Body& center = bodies[wh.central];
+    double gm = (double)G*center.mass;
+    double c[3];
+    BodyOffset(center, c);
+    for (size_t i = 0; i < bodies.size(); i++) {
+        Body& b = bodies[i];
+        if (b.isFixed) continue;
+        double r[3];
+        double* v = &wh.velocity[3*i];
+        BodyOffset(b, r);
+        for (int k = 0; k < 3; k++) r[k] -= c[k];
+        if (KeplerDrift(gm, r, v, dt)) {
+            SetBodyOffset(b, c[0] + r[0], c[1] + r[1], c[2] + r[2]);
+        } else {
+            // Не сошлось (тело в центре): хотя бы прямолинейно
+            SetBodyOffset(b, c[0] + r[0] + v[0]*dt, c[1] + r[1] + v[1]*dt, c[2] + r[2] + v[2]*dt);
+        }
+    }
+}
+
+inline void WisdomHolmanKick(std::vector<Body>& bodies, WisdomHolman& wh, double dt) {
+    for (size_t i = 0; i < bodies.size(); i++) {
+        if (bodies[i].isFixed) continue;
+        double* v = &wh.velocity[3*i];
+        v[0] += wh.acc[i].x*dt; v[1] += wh.acc[i].y*dt; v[2] += wh.acc[i].z*dt;
+        bodies[i].velocity = { (float)v[0], (float)v[1], (float)v[2] };
+    }
+}
+
+inline void StepWisdomHolman(std::vector<Body>& bodies, float dt, const GravitySettings& settings, GravityWorkspace& ws) {
+    WisdomHolman& wh = ws.wh;
+    bool fresh = !wh.valid || wh.velocity.size() != 3*bodies.size();
+    if (fresh) InitWisdomHolman(bodies, wh);
+    if (wh.central < 0) {
+        if (fresh) ws.leapfrogValid = false;
+        StepLeapfrog(bodies, dt, settings, ws);
+        return;
+    }
+    if (fresh) WisdomHolmanKicks(bodies, settings, ws);
+    // Допуск на округление float: шаг ровно в maxStep не должен делиться надвое
+    int substeps = (wh.maxStep > 0.0) ? std::max(1, (int)ceil(dt/wh.maxStep - 1e-6)) : 1;
+    double h = (double)dt/substeps;
+    for (int s = 0; s < substeps; s++) {
+        WisdomHolmanKick(bodies, wh, 0.5*h);
+        KeplerDriftBodies(bodies, wh, h);
+        WisdomHolmanKicks(bodies, settings, ws);
+        WisdomHolmanKick(bodies, wh, 0.5*h);
+    }
+}
+
+inline void StepPhysics(std::vector<Body>& bodies, float dt, const GravitySettings& settings, GravityWorkspace& ws) {
+    switch (settings.integrator) {
+        case INTEGRATOR_LEAPFROG: StepLeapfrog(bodies, dt, settings, ws); break;
+        case INTEGRATOR_ADAPTIVE: StepAdaptiveLeapfrog(bodies, dt, ws); break;
+        case INTEGRATOR_HERMITE: StepHermite(bodies, dt, ws.hermite, ws.pool); break;
+        case INTEGRATOR_WISDOM_HOLMAN: StepWisdomHolman(bodies, dt, settings, ws); break;
+        default: StepEuler(bodies, dt, settings, ws); break;
+    }
+}
+
+#endif
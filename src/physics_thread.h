@@ -0,0 +1,541 @@
+#ifndef PHYSICS_THREAD_H
+#define PHYSICS_THREAD_H
+
+#include "raylib.h"
+#include "raymath.h"
+#include "physics.h"
+#include "timestep.h"
+#include "floating_origin.h"
+#include "thread_pool.h"
+#include "frame_budget.h"
+#include "timeline.h"
+#include "collisions.h"
+#include "slot_map.h"
+#include "culling.h"
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+// --- ПОТОК ФИЗИКИ ---
+// Симуляция живёт в своём потоке и никогда не ждёт отрисовку, а отрисовка —
+// симуляцию. Назад идут снимки состояния через тройной буфер, вперёд —
+// команды интерфейса через очередь одного писателя и одного читателя.
+// Ни там, ни там нет блокировок. Где потоков нет (веб-сборка без pthreads),
+// тот же шаг физики вызывается прямо из цикла кадра.
+
+#if !defined(GRAVITY_PHYSICS_THREAD)
+    #if defined(PLATFORM_WEB) || defined(__EMSCRIPTEN__)
+        #define GRAVITY_PHYSICS_THREAD 0
+    #else
+        #define GRAVITY_PHYSICS_THREAD 1
+    #endif
+#endif
+
+const int FRAME_HZ = 60;
+const int SUBSTEPS = 8;              // тиков физики на кадр, пока регулятор не решит иначе
+const int PHYSICS_HZ = FRAME_HZ*SUBSTEPS;  // тиков физики в секунду реального времени при SUBSTEPS
+const double PHYSICS_LOAD_WINDOW = 0.1;    // с; за такое окно меряем затраты физики
+const int FAST_FORWARD_FPS = 10;           // кадров в секунду при перемотке
+const double FAST_FORWARD_SLICE = 0.05;    // с; поток физики между проверками команд
+const int MAX_CATCHUP_FRAMES = 4;    // догоняем не больше 4 кадров за раз
+const int VERIFY_MAX_BODIES = 4000;  // выше этого сверка с прямой суммой слишком дорога
+
+inline double PhysicsNow() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// --- ТРОЙНОЙ БУФЕР ---
+// Писатель заполняет свой слот и меняет его местами со средним; читатель
+// забирает средний, только если там есть свежий снимок. Оба держат по
+// собственному слоту, поэтому ни один не ждёт другого; промежуточные
+// снимки, которые читатель не успел взять, просто перезаписываются.
+
+const int TRIPLE_FRESH = 4;  // бит «в среднем слоте непрочитанный снимок»
+
+template <typename T>
+struct TripleBuffer {
+    T slots[3];
+    std::atomic<int> middle{1};  // индекс среднего слота | TRIPLE_FRESH
+    int back = 0;                // слот писателя
+    int front = 2;               // слот читателя
+};
+
+template <typename T>
+inline T& WriteSlot(TripleBuffer<T>& buffer) {
+    return buffer.slots[buffer.back];
+}
+
+template <typename T>
+inline void PublishSlot(TripleBuffer<T>& buffer) {
+    int previous = buffer.middle.exchange(buffer.back | TRIPLE_FRESH, std::memory_order_acq_rel);
+    buffer.back = previous & 3;
+}
+
+// true, если появился новый снимок; ReadSlot остаётся прежним до следующего вызова
+template <typename T>
+inline bool AcquireSlot(TripleBuffer<T>& buffer) {
+    if ((buffer.middle.load(std::memory_order_relaxed) & TRIPLE_FRESH) == 0) return false;
+    int previous = buffer.middle.exchange(buffer.front, std::memory_order_acq_rel);
+    buffer.front = previous & 3;
+    return true;
+}
+
+template <typename T>
+inline const T& ReadSlot(const TripleBuffer<T>& buffer) {
+    return buffer.slots[buffer.front];
+}
+
+// --- КОМАНДЫ ИНТЕРФЕЙСА ---
+enum PhysicsCommandType {
+    CMD_SPAWN,     // body в координатах origin
+    CMD_RESET,
+    CMD_PAUSE,     // flag
+    CMD_SPEED,     // value
+    CMD_SETTINGS,  // settings, заодно сверка с прямой суммой
+    CMD_REBASE,    // anchor в координатах origin, value = шаг привязки
+    CMD_BUDGET,    // substeps, value = доля скорости времени (frame_budget.h)
+    CMD_FAST_FORWARD, // flag
+    CMD_SEEK          // time — перемотка по линии времени
+};
+
+struct PhysicsCommand {
+    PhysicsCommandType type;
+    Body body;
+    WorldOrigin origin;  // начало координат, в котором интерфейс видел сцену
+    Vector3 anchor;
+    float value;
+    bool flag;
+    int substeps;
+    double time;
+    GravitySettings settings;
+};
+
+const size_t COMMAND_QUEUE_SIZE = 256;  // степень двойки
+
+// Кольцо одного писателя (интерфейс) и одного читателя (физика)
+struct CommandQueue {
+    PhysicsCommand items[COMMAND_QUEUE_SIZE];
+    std::atomic<size_t> head{0};  // следующая для чтения
+    std::atomic<size_t> tail{0};  // следующая для записи
+};
+
+inline bool PushCommand(CommandQueue& queue, const PhysicsCommand& command) {
+    size_t tail = queue.tail.load(std::memory_order_relaxed);
+    if (tail - queue.head.load(std::memory_order_acquire) >= COMMAND_QUEUE_SIZE) return false;
+    queue.items[tail & (COMMAND_QUEUE_SIZE - 1)] = command;
+    queue.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+inline bool PopCommand(CommandQueue& queue, PhysicsCommand* command) {
+    size_t head = queue.head.load(std::memory_order_relaxed);
+    if (head == queue.tail.load(std::memory_order_acquire)) return false;
+    *command = queue.items[head & (COMMAND_QUEUE_SIZE - 1)];
+    queue.head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+// --- СНИМОК ДЛЯ ОТРИСОВКИ ---
+struct PhysicsSnapshot {
+    SlotMap<Body> bodies;  // dense — для отрисовки, ручки — для камеры и выбора
+    std::vector<Vector3> previous;  // позиции перед последним шагом
+    WorldOrigin origin = { 0.0, 0.0, 0.0 };
+    GravitySettings gravity = DefaultGravitySettings();
+    double publishTime = 0.0;  // PhysicsNow() в момент публикации
+    double tick = 1.0;         // длина тика, с
+    float alpha = 0.0f;        // доля тика в аккумуляторе на момент публикации
+    float solverError = -1.0f; // -1 = ещё не сверяли
+    bool saturated = false;
+    bool blockSteps = false;   // у схемы шаги по телам, blocks заполнен
+    BlockStats blocks = { 0, 0, 0, 0 };
+    int encounterPairs = 0;    // тесных пар, которые leapfrog ведёт по Кеплеру
+    float stepDt = 0.0f;       // шаг симуляции одного тика
+    int substeps = SUBSTEPS;
+    float timeScale = 1.0f;
+    float physicsMs = 0.0f;    // затраты физики на кадр FRAME_HZ, мс
+    float simRate = 0.0f;      // секунд симуляции за секунду реального времени
+    bool fastForward = false;
+    float timeSpeed = 1.0f;
+    double time = 0.0;         // время симуляции
+    double timelineStart = 0.0;  // куда ещё можно перемотать
+    double timelineEnd = 0.0;
+    int keyframes = 0;
+    int restores = 0;          // растёт, когда физика взяла настройки из ключевого кадра
+};
+
+// Доля тика к моменту now: продолжаем ход аккумулятора после публикации
+inline float SnapshotAlpha(const PhysicsSnapshot& snapshot, double now) {
+    float alpha = snapshot.alpha + (float)((now - snapshot.publishTime)/snapshot.tick);
+    return (alpha > 1.0f) ? 1.0f : (alpha < 0.0f ? 0.0f : alpha);
+}
+
+// --- СИМУЛЯЦИЯ ---
+struct PhysicsSim {
+    SlotMap<Body> bodies;  // dense идёт в ядра; снаружи тела держат по ручкам
+    std::vector<Vector3> previous;
+    GravitySettings gravity;
+    GravityWorkspace ws;
+    WorldOrigin origin = { 0.0, 0.0, 0.0 };
+    FixedTimestep timestep = MakeFixedTimestep(1.0/PHYSICS_HZ, SUBSTEPS*MAX_CATCHUP_FRAMES);
+    float timeSpeed = 1.0f;
+    int substeps = SUBSTEPS;  // решения регулятора бюджета кадра
+    float timeScale = 1.0f;
+    double whStep = 0.0;      // шаг Wisdom-Holman; 0 — шаг от BASE_DT
+    double workTime = 0.0;    // время шагов в текущем окне замера
+    double workWindow = 0.0;  // реальное время окна
+    double simAdvance = 0.0;  // время симуляции за окно
+    float physicsMs = 0.0f;
+    float simRate = 0.0f;
+    bool paused = false;
+    bool fastForward = false;  // шаги без оглядки на реальное время
+    Timeline timeline;
+    CollisionState collisions;
+    bool collide = true;       // сливать касающиеся тела (collisions.h)
+    CullRules cull;            // убирать улетевших и упавших (culling.h)
+    CullState culling;
+    long long stepIndex = 0;   // шагов с начала прогона (по текущей ветке)
+    double time = 0.0;         // время симуляции
+    int restores = 0;
+    float solverError = -1.0f;
+    bool verifySolver = true;
+    bool changed = true;  // есть что публиковать
+
+    CommandQueue commands;
+    TripleBuffer<PhysicsSnapshot> snapshots;
+    std::thread thread;
+    std::atomic<bool> quit{false};
+    bool threaded = false;
+};
+
+// Длина тика следует за схемой: крупный шаг leapfrog — реже тики.
+// Регулятор бюджета меняет число тиков на кадр: меньше подшагов — тик
+// длиннее, а шаг симуляции растёт так же (скорость времени прежняя);
+// timeScale < 1 растягивает тик без роста шага — время идёт медленнее.
+// Wisdom-Holman шагает долей периода (whStep): тик — время, за которое
+// при заказанной скорости проходит один такой шаг.
+inline void ConfigureTimestep(PhysicsSim& sim) {
+    int stride = IntegratorStride(sim.gravity.integrator);
+    sim.timestep.tick = (double)stride/(FRAME_HZ*sim.substeps*sim.timeScale);
+    if (sim.whStep > 0.0) sim.timestep.tick = sim.whStep/((double)BASE_DT*SUBSTEPS*FRAME_HZ*sim.timeSpeed*sim.timeScale);
+    sim.timestep.maxSteps = std::max(1, sim.substeps*MAX_CATCHUP_FRAMES/stride);
+}
+
+// Шаг симуляции одного тика: BASE_DT * stride * timeSpeed при SUBSTEPS
+// подшагах, у Wisdom-Holman — доля периода
+inline float PhysicsStepDt(const PhysicsSim& sim) {
+    if (sim.whStep > 0.0) return (float)sim.whStep;
+    return BASE_DT*IntegratorStride(sim.gravity.integrator)*sim.timeSpeed*(float)SUBSTEPS/sim.substeps;
+}
+
+// Доля периода пересчитывается по телам на каждом ключевом кадре: между
+// кадрами шаг один, и досчёт повторяет его
+inline void UpdateWisdomHolmanStep(PhysicsSim& sim) {
+    sim.whStep = (sim.gravity.integrator == INTEGRATOR_WISDOM_HOLMAN) ? WisdomHolmanStep(sim.bodies.dense) : 0.0;
+    ConfigureTimestep(sim);
+}
+
+// --- ЛИНИЯ ВРЕМЕНИ ---
+// Кадр на текущем шаге; он же точка перезапуска схем (timeline.h)
+inline void CaptureKeyframe(PhysicsSim& sim) {
+    UpdateWisdomHolmanStep(sim);
+    Keyframe& k = PushKeyframe(sim.timeline, sim.stepIndex, sim.bodies.dense.size());
+    k.step = sim.stepIndex;
+    k.time = sim.time;
+    k.dt = PhysicsStepDt(sim);
+    k.origin = sim.origin;
+    k.gravity = sim.gravity;
+    k.timeSpeed = sim.timeSpeed;
+    k.substeps = sim.substeps;
+    k.timeScale = sim.timeScale;
+    k.whStep = sim.whStep;
+    k.bodies = sim.bodies;
+    InvalidateAccelerationCache(sim.ws);
+}
+
+inline void RestoreKeyframe(PhysicsSim& sim, const Keyframe& k) {
+    bool settingsChanged = k.gravity.solver != sim.gravity.solver || k.gravity.theta != sim.gravity.theta;
+    RestoreSlots(sim.bodies, k.bodies);
+    sim.origin = k.origin;
+    sim.gravity = k.gravity;
+    sim.timeSpeed = k.timeSpeed;
+    sim.substeps = k.substeps;
+    sim.timeScale = k.timeScale;
+    sim.whStep = k.whStep;
+    sim.stepIndex = k.step;
+    sim.time = k.time;
+    SavePositions(sim.bodies.dense, sim.previous);  // не интерполируем через восстановление
+    InvalidateSweepAndPrune(sim.collisions.sap);
+    if (settingsChanged) sim.verifySolver = true;  // как после CMD_SETTINGS
+    ConfigureTimestep(sim);
+    InvalidateAccelerationCache(sim.ws);
+    sim.restores++;
+}
+
+// Событие, которое шагами не повторить: прежнее будущее ветки не наступит
+inline void TimelineEvent(PhysicsSim& sim) {
+    TruncateTimeline(sim.timeline, sim.stepIndex, sim.time);
+    CaptureKeyframe(sim);
+}
+
+// Шаг симуляции; на шаге ключевого кадра (после перемотки назад) берём
+// сам кадр — так повторяются и записанные там события. Возвращает dt шага.
+inline float AdvancePhysics(PhysicsSim& sim) {
+    float dt = PhysicsStepDt(sim);
+    if (sim.collide) BeginCollisionStep(sim.collisions, sim.bodies.dense);
+    StepPhysics(sim.bodies.dense, dt, sim.gravity, sim.ws);
+    // Слияния зависят только от состояния — при досчёте повторяются сами
+    if (sim.collide && ResolveCollisions(sim.bodies.dense, sim.collisions)) {
+        RetainSlots(sim.bodies, sim.collisions.survivors);
+        RemapPositions(sim.previous, sim.collisions.survivors);
+        InvalidateAccelerationCache(sim.ws);
+    }
+    sim.stepIndex++;
+    sim.time += dt;
+    // Уборка по номеру шага, а не по кадру: досчёт повторяет её сам
+    if (sim.stepIndex % CULL_INTERVAL == 0 && CullBodies(sim.bodies, sim.cull, sim.culling)) {
+        RemapPositions(sim.previous, sim.culling.from);
+        RemapSweepAndPrune(sim.collisions.sap, sim.culling.from);
+        InvalidateAccelerationCache(sim.ws);
+    }
+    Timeline& tl = sim.timeline;
+    if (sim.stepIndex > tl.horizonStep) {
+        tl.horizonStep = sim.stepIndex;
+        tl.horizonTime = sim.time;
+    }
+    int index = FindKeyframeStep(tl, sim.stepIndex);
+    if (index >= 0) RestoreKeyframe(sim, TimelineAt(tl, index));
+    else if (tl.count == 0 || sim.stepIndex - TimelineAt(tl, tl.count - 1).step >= KEYFRAME_INTERVAL) CaptureKeyframe(sim);
+    return dt;
+}
+
+// Ближайший кадр не позже time и досчёт от него: не больше KEYFRAME_INTERVAL шагов
+inline void SeekTimeline(PhysicsSim& sim, double time) {
+    Timeline& tl = sim.timeline;
+    double target = std::clamp(time, TimelineStart(tl), tl.horizonTime);
+    int index = FindKeyframe(tl, target);
+    if (index < 0) return;
+    const Keyframe& k = TimelineAt(tl, index);
+    long long steps = std::min(llround((target - k.time)/k.dt), tl.horizonStep - k.step);
+    if (index + 1 < tl.count && k.step + steps >= TimelineAt(tl, index + 1).step) {
+        // Округление дотянуло до следующего кадра — он и есть цель
+        index++;
+        steps = 0;
+    }
+    RestoreKeyframe(sim, TimelineAt(tl, index));
+    for (long long s = 0; s < steps; s++) AdvancePhysics(sim);
+    SavePositions(sim.bodies.dense, sim.previous);
+    sim.timestep.accumulator = 0.0;
+}
+
+// Сдвиг из начала координат from в начало to
+inline Vector3 OriginDelta(const WorldOrigin& from, const WorldOrigin& to) {
+    return { (float)(from.x - to.x), (float)(from.y - to.y), (float)(from.z - to.z) };
+}
+
+inline void ApplyPhysicsCommand(PhysicsSim& sim, const PhysicsCommand& command) {
+    switch (command.type) {
+        case CMD_SPAWN: {
+            Body body = command.body;
+            Vector3 delta = OriginDelta(command.origin, sim.origin);
+            SetBodyOffset(body, (double)body.position.x + delta.x, (double)body.position.y + delta.y, (double)body.position.z + delta.z);
+            InsertSlot(sim.bodies, body);
+            TimelineEvent(sim);
+            break;
+        }
+        case CMD_RESET:
+            ClearSlots(sim.bodies);  // старые ручки больше ничего не находят
+            InsertSlot(sim.bodies, { {0,0,0}, {0,0,0}, 5000.0f, 10.0f, GOLD, true });
+            sim.origin = { 0.0, 0.0, 0.0 };
+            SavePositions(sim.bodies.dense, sim.previous);
+            InvalidateSweepAndPrune(sim.collisions.sap);
+            TimelineEvent(sim);  // прежняя сцена остаётся в прошлом линии времени
+            break;
+        case CMD_PAUSE:
+            sim.paused = command.flag;
+            break;
+        case CMD_SPEED:
+            sim.timeSpeed = command.value;
+            TimelineEvent(sim);
+            break;
+        case CMD_SETTINGS:
+            sim.gravity = command.settings;
+            sim.verifySolver = true;
+            ConfigureTimestep(sim);
+            TimelineEvent(sim);
+            break;
+        case CMD_REBASE: {
+            Vector3 anchor = Vector3Add(command.anchor, OriginDelta(command.origin, sim.origin));
+            Vector3 shift = RebaseOrigin(sim.bodies.dense, sim.origin, anchor, command.value);
+            ShiftPositions(sim.previous, shift);
+            // Сдвинутые координаты округлены иначе — досчёт от старых кадров разошёлся бы.
+            // Кадр заодно сбрасывает кэши интеграторов: Эрмит стартует с новых координат
+            if (Vector3LengthSqr(shift) > 0.0f) TimelineEvent(sim);
+            break;
+        }
+        case CMD_FAST_FORWARD:
+            sim.fastForward = command.flag;
+            sim.timestep.accumulator = 0.0;  // после перемотки не догоняем
+            break;
+        case CMD_BUDGET:
+            sim.substeps = std::max(1, command.substeps);
+            sim.timeScale = command.value;
+            ConfigureTimestep(sim);
+            TimelineEvent(sim);
+            break;
+        case CMD_SEEK:
+            SeekTimeline(sim, command.time);
+            break;
+    }
+    sim.changed = true;
+}
+
+inline void PublishSnapshot(PhysicsSim& sim, double now) {
+    PhysicsSnapshot& snapshot = WriteSlot(sim.snapshots);
+    snapshot.bodies = sim.bodies;
+    snapshot.previous = sim.previous;
+    snapshot.origin = sim.origin;
+    snapshot.gravity = sim.gravity;
+    snapshot.publishTime = now;
+    snapshot.tick = sim.timestep.tick;
+    snapshot.alpha = (sim.paused || sim.fastForward) ? 1.0f : TimestepAlpha(sim.timestep);
+    snapshot.solverError = sim.solverError;
+    snapshot.saturated = sim.timestep.saturated;
+    const BlockStats* blocks = IntegratorBlockStats(sim.ws, sim.gravity.integrator);
+    snapshot.blockSteps = blocks != nullptr;
+    if (blocks) snapshot.blocks = *blocks;
+    snapshot.encounterPairs = (int)sim.ws.encounters.pairs.size();
+    snapshot.stepDt = PhysicsStepDt(sim);
+    snapshot.substeps = sim.substeps;
+    snapshot.timeScale = sim.timeScale;
+    snapshot.physicsMs = sim.physicsMs;
+    snapshot.simRate = sim.simRate;
+    snapshot.fastForward = sim.fastForward;
+    snapshot.timeSpeed = sim.timeSpeed;
+    snapshot.time = sim.time;
+    snapshot.timelineStart = TimelineStart(sim.timeline);
+    snapshot.timelineEnd = sim.timeline.horizonTime;
+    snapshot.keyframes = sim.timeline.count;
+    snapshot.restores = sim.restores;
+    PublishSlot(sim.snapshots);
+    sim.changed = false;
+}
+
+// Один проход: команды, сверка решателя, шаги за frameTime, публикация
+inline void RunPhysicsFrame(PhysicsSim& sim, float frameTime, double now) {
+    // Перемотки подряд (палец ведёт по полосе) сводим к последней
+    PhysicsCommand command, seek;
+    bool seekPending = false;
+    while (PopCommand(sim.commands, &command)) {
+        if (command.type == CMD_SEEK) {
+            seek = command;
+            seekPending = true;
+            continue;
+        }
+        if (seekPending) ApplyPhysicsCommand(sim, seek);
+        seekPending = false;
+        ApplyPhysicsCommand(sim, command);
+    }
+    if (seekPending) ApplyPhysicsCommand(sim, seek);
+
+    // Сверяем с прямой суммой, пока сцена маленькая
+    if (sim.verifySolver && sim.bodies.dense.size() <= (size_t)VERIFY_MAX_BODIES) {
+        sim.solverError = MeasureSolverError(sim.bodies.dense, sim.gravity, sim.ws);
+        if (sim.solverError > sim.gravity.tolerance) {
+            TraceLog(LOG_WARNING, "Solver %s (theta %.2f) error %.4f exceeds tolerance %.4f", GravitySolverName(sim.gravity.solver), sim.gravity.theta, sim.solverError, sim.gravity.tolerance);
+        }
+    }
+    sim.verifySolver = false;
+
+    // Тики постоянной длины из накопленного реального времени; шаг симуляции
+    // из PhysicsStepDt, число шагов задаёт реальное время. При быстрой перемотке шаг
+    // тот же (орбиты не теряют точность), но шаги идут подряд весь отрезок
+    // slice, а снимок уходит раз за отрезок.
+    if (!sim.paused) {
+        double start = PhysicsNow();
+        double advanced = 0.0;
+        int steps = 0;
+        if (sim.fastForward) {
+            double slice = sim.threaded ? FAST_FORWARD_SLICE : 1.0/FAST_FORWARD_FPS;
+            do {
+                advanced += AdvancePhysics(sim);
+                steps++;
+            } while (PhysicsNow() - start < slice);
+            SavePositions(sim.bodies.dense, sim.previous);
+            frameTime = (float)(PhysicsNow() - start);
+        } else {
+            steps = AdvanceTimestep(sim.timestep, frameTime);
+            for (int step = 0; step < steps; step++) {
+                if (step == steps - 1) SavePositions(sim.bodies.dense, sim.previous);
+                advanced += AdvancePhysics(sim);
+            }
+        }
+        if (steps > 0) sim.changed = true;
+        // Доля реального времени, занятая шагами, в пересчёте на кадр FRAME_HZ,
+        // и темп симуляции
+        sim.workTime += PhysicsNow() - start;
+        sim.workWindow += frameTime;
+        sim.simAdvance += advanced;
+        if (sim.workWindow >= PHYSICS_LOAD_WINDOW) {
+            sim.physicsMs = (float)(sim.workTime/sim.workWindow*1000.0/FRAME_HZ);
+            sim.simRate = (float)(sim.simAdvance/sim.workWindow);
+            sim.workTime = 0.0;
+            sim.workWindow = 0.0;
+            sim.simAdvance = 0.0;
+            sim.changed = true;
+        }
+    }
+    if (sim.changed) PublishSnapshot(sim, now);
+}
+
+inline void PhysicsThreadLoop(PhysicsSim* sim) {
+    double last = PhysicsNow();
+    while (!sim->quit.load(std::memory_order_relaxed)) {
+        double now = PhysicsNow();
+        RunPhysicsFrame(*sim, (float)(now - last), now);
+        last = now;
+        // Спим до следующего тика (на паузе — просто ждём команд, при перемотке не спим)
+        // Не дольше кадра: тик Wisdom-Holman бывает в секунды, а команды ждать не должны
+        double wait = sim->paused ? 0.005 : sim->timestep.tick - sim->timestep.accumulator;
+        if (sim->fastForward && !sim->paused) wait = 0.0;
+        wait = std::min(wait, 1.0/FRAME_HZ);
+        if (wait > 0.0) std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+    }
+}
+
+inline void StartPhysics(PhysicsSim& sim, const std::vector<Body>& bodies, const GravitySettings& gravity, ThreadPool* pool, bool threaded) {
+    AssignSlots(sim.bodies, bodies);
+    sim.gravity = gravity;
+    sim.ws.pool = pool;
+    ConfigureTimestep(sim);
+    SavePositions(sim.bodies.dense, sim.previous);
+    CaptureKeyframe(sim);  // начало линии времени
+    sim.threaded = threaded && GRAVITY_PHYSICS_THREAD;
+    // Первый снимок до старта потока: отрисовке сразу есть что показать
+    RunPhysicsFrame(sim, 0.0f, PhysicsNow());
+    if (sim.threaded) sim.thread = std::thread(PhysicsThreadLoop, &sim);
+    TraceLog(LOG_INFO, "PHYSICS: %s, %s at %.3g Hz", sim.threaded ? "own thread" : "inline in the frame loop",
+        IntegratorName(sim.gravity.integrator), 1.0/sim.timestep.tick);
+}
+
+// Без потока физика продвигается отсюда, раз за кадр
+inline void UpdatePhysicsInline(PhysicsSim& sim, float frameTime) {
+    if (!sim.threaded) RunPhysicsFrame(sim, frameTime, PhysicsNow());
+}
+
+inline void StopPhysics(PhysicsSim& sim) {
+    if (!sim.threaded) return;
+    sim.quit.store(true);
+    sim.thread.join();
+    sim.threaded = false;
+}
+
+// Для интерфейса: false, если очередь переполнена (команда теряется)
+inline bool SendPhysicsCommand(PhysicsSim& sim, const PhysicsCommand& command) {
+    if (PushCommand(sim.commands, command)) return true;
+    TraceLog(LOG_WARNING, "PHYSICS: command queue full, dropping command %d", (int)command.type);
+    return false;
+}
+
+#endif
@@ -0,0 +1,271 @@
+#ifndef PM_SOLVER_H
+#define PM_SOLVER_H
+
+#include "gravity.h"
+#include "thread_pool.h"
+#include <vector>
+#include <complex>
+#include <cmath>
+
+// --- PARTICLE-MESH ---
+// Масса раскладывается на кубическую сетку (cloud-in-cell), потенциал находится
+// через БПФ, ускорение — центральными разностями на сетке и обратной
+// CIC-интерполяцией в тела. Хорош для плотных почти однородных облаков;
+// масштабы меньше пары ячеек сглаживаются.
+// Изолированные границы: сетка охватывает все тела, свёртка с 1/r идёт на
+// сетке удвоенного размера (нулевое дополнение), поэтому образов нет.
+// Периодические границы: куб со стороной boxSize вокруг начала координат,
+// тела вне куба видят себя через периодический образ; средняя плотность
+// вычитается (мода k = 0 обнуляется).
+
+typedef std::complex<float> PmComplex;
+
+struct PmSolver {
+    int grid = 0;              // ячеек по оси (степень двойки)
+    int fftSize = 0;           // grid или 2*grid для изолированных границ
+    PmBoundary boundary = PM_ISOLATED;
+    std::vector<PmComplex> mesh;      // fftSize^3
+    std::vector<PmComplex> green;     // образ Фурье функции Грина
+    std::vector<PmComplex> twiddles;  // e^{-2 pi i k / fftSize}
+    std::vector<int> bitReverse;
+    std::vector<float> ax, ay, az;    // ускорения на сетке grid^3 без G
+    float origin[3];
+    float cellSize = 1.0f;
+};
+
+inline int PmRoundGrid(int grid) {
+    int n = 8;
+    while (n < grid && n < 256) n *= 2;
+    return n;
+}
+
+// --- БПФ ---
+// Произведение без проверок NaN/Inf из operator* (он уходит в __mulsc3)
+inline PmComplex PmMul(PmComplex a, PmComplex b) {
+    return PmComplex(a.real()*b.real() - a.imag()*b.imag(), a.real()*b.imag() + a.imag()*b.real());
+}
+
+// Итеративное radix-2 по одной линии длины fftSize
+inline void PmFftLine(const PmSolver& pm, PmComplex* line, bool inverse) {
+    int n = pm.fftSize;
+    for (int i = 0; i < n; i++) {
+        int j = pm.bitReverse[i];
+        if (j > i) std::swap(line[i], line[j]);
+    }
+    for (int len = 2; len <= n; len *= 2) {
+        int half = len/2;
+        int step = n/len;
+        for (int start = 0; start < n; start += len) {
+            for (int k = 0; k < half; k++) {
+                PmComplex w = pm.twiddles[k*step];
+                if (inverse) w = std::conj(w);
+                PmComplex u = line[start + k];
+                PmComplex v = PmMul(line[start + k + half], w);
+                line[start + k] = u + v;
+                line[start + k + half] = u - v;
+            }
+        }
+    }
+}
+
+// Трёхмерное БПФ по осям; линии независимы, поэтому результат не зависит от потоков.
+// Обратное преобразование не нормируется.
+// limit < fftSize — нулевое дополнение: прямое БПФ идёт по осям x, y, z и
+// пропускает линии, где ещё не преобразованные координаты >= limit (там нули);
+// обратное идёт z, y, x и не считает линии, выходящие за нужную область.
+inline void PmFft3D(PmSolver& pm, std::vector<PmComplex>& data, bool inverse, size_t limit, ThreadPool* pool) {
+    size_t n = (size_t)pm.fftSize;
+    size_t strides[3] = { 1, n, n*n };
+    for (int pass = 0; pass < 3; pass++) {
+        int axis = inverse ? 2 - pass : pass;
+        size_t stride = strides[axis];
+        // Линия задаётся двумя другими координатами: a по младшей оси, b по старшей
+        size_t countA = (axis == 0) ? limit : n;
+        size_t countB = (axis < 2) ? limit : n;
+        ParallelFor(pool, countA*countB, 64, [&](size_t begin, size_t end) {
+            std::vector<PmComplex> line(n);
+            for (size_t l = begin; l < end; l++) {
+                size_t a = l % countA, b = l / countA;
+                size_t base;
+                if (axis == 0) base = a*n + b*n*n;
+                else if (axis == 1) base = a + b*n*n;
+                else base = a + b*n;
+                for (size_t i = 0; i < n; i++) line[i] = data[base + i*stride];
+                PmFftLine(pm, line.data(), inverse);
+                for (size_t i = 0; i < n; i++) data[base + i*stride] = line[i];
+            }
+        });
+    }
+}
+
+// --- ФУНКЦИЯ ГРИНА ---
+inline void BuildPmGreen(PmSolver& pm, ThreadPool* pool) {
+    size_t n = (size_t)pm.fftSize;
+    pm.green.assign(n*n*n, PmComplex(0.0f, 0.0f));
+    if (pm.boundary == PM_ISOLATED) {
+        // 1/r в единицах ячеек с минимальным образом; в нуле — 1 (сглаживание на ячейку)
+        for (size_t k = 0; k < n; k++) {
+            for (size_t j = 0; j < n; j++) {
+                for (size_t i = 0; i < n; i++) {
+                    float dx = (float)((i <= n/2) ? i : n - i);
+                    float dy = (float)((j <= n/2) ? j : n - j);
+                    float dz = (float)((k <= n/2) ? k : n - k);
+                    float r = sqrtf(dx*dx + dy*dy + dz*dz);
+                    pm.green[(k*n + j)*n + i] = PmComplex((r > 0.0f) ? 1.0f/r : 1.0f, 0.0f);
+                }
+            }
+        }
+        PmFft3D(pm, pm.green, false, n, pool);
+    } else {
+        // Обратный дискретный лапласиан: phi_k = -4 pi rho_k / k_eff^2, в единицах ячеек
+        for (size_t k = 0; k < n; k++) {
+            for (size_t j = 0; j < n; j++) {
+                for (size_t i = 0; i < n; i++) {
+                    if (i == 0 && j == 0 && k == 0) continue;
+                    float sx = sinf(PI*i/n), sy = sinf(PI*j/n), sz = sinf(PI*k/n);
+                    float kSq = 4.0f*(sx*sx + sy*sy + sz*sz);
+                    pm.green[(k*n + j)*n + i] = PmComplex(4.0f*PI/kSq, 0.0f);
+                }
+            }
+        }
+    }
+}
+
+inline void PreparePmSolver(PmSolver& pm, int grid, PmBoundary boundary, ThreadPool* pool) {
+    grid = PmRoundGrid(grid);
+    if (pm.grid == grid && pm.boundary == boundary) return;
+    pm.grid = grid;
+    pm.boundary = boundary;
+    pm.fftSize = (boundary == PM_ISOLATED) ? 2*grid : grid;
+
+    int n = pm.fftSize;
+    int bits = 0;
+    while ((1 << bits) < n) bits++;
+    pm.bitReverse.resize(n);
+    for (int i = 0; i < n; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++) if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        pm.bitReverse[i] = r;
+    }
+    pm.twiddles.resize(n/2);
+    for (int k = 0; k < n/2; k++) pm.twiddles[k] = std::polar(1.0f, -2.0f*PI*k/n);
+    BuildPmGreen(pm, pool);
+}
+
+// --- CIC ---
+// Координата в ячейках относительно центров ячеек; возвращает базовый индекс и веса
+inline void PmCicWeights(float u, int grid, bool periodic, int* i0, int* i1, float* w1) {
+    float f = floorf(u);
+    int i = (int)f;
+    *w1 = u - f;
+    if (periodic) {
+        i %= grid;
+        if (i < 0) i += grid;
+        *i0 = i;
+        *i1 = (i + 1) % grid;
+    } else {
+        if (i < 0) { i = 0; *w1 = 0.0f; }
+        if (i > grid - 2) { i = grid - 2; *w1 = 1.0f; }
+        *i0 = i;
+        *i1 = i + 1;
+    }
+}
+
+inline void ComputeAccelerationsPm(const std::vector<Body>& bodies, std::vector<Vector3>& acc, PmSolver& pm, int grid, PmBoundary boundary, float boxSize, ThreadPool* pool) {
+    acc.assign(bodies.size(), {0,0,0});
+    if (bodies.empty()) return;
+    PreparePmSolver(pm, grid, boundary, pool);
+    int g = pm.grid;
+    size_t n = (size_t)pm.fftSize;
+    bool periodic = (boundary == PM_PERIODIC);
+
+    // Область сетки
+    if (periodic) {
+        pm.cellSize = boxSize/g;
+        for (int a = 0; a < 3; a++) pm.origin[a] = -0.5f*boxSize;
+    } else {
+        Vector3 lo = bodies[0].position, hi = bodies[0].position;
+        for (const Body& b : bodies) { lo = Vector3Min(lo, b.position); hi = Vector3Max(hi, b.position); }
+        float extent = fmaxf(fmaxf(hi.x - lo.x, hi.y - lo.y), fmaxf(hi.z - lo.z, 1e-3f));
+        // Две ячейки запаса с каждой стороны, чтобы CIC и разности не выходили за край
+        pm.cellSize = extent/(g - 4);
+        Vector3 center = Vector3Scale(Vector3Add(lo, hi), 0.5f);
+        pm.origin[0] = center.x - 0.5f*g*pm.cellSize;
+        pm.origin[1] = center.y - 0.5f*g*pm.cellSize;
+        pm.origin[2] = center.z - 0.5f*g*pm.cellSize;
+    }
+    float h = pm.cellSize;
+    float invH = 1.0f/h;
+
+    // Раскладка массы
+    pm.mesh.assign(n*n*n, PmComplex(0.0f, 0.0f));
+    for (const Body& b : bodies) {
+        int x0, x1, y0, y1, z0, z1;
+        float wx, wy, wz;
+        PmCicWeights((b.position.x - pm.origin[0])*invH - 0.5f, g, periodic, &x0, &x1, &wx);
+        PmCicWeights((b.position.y - pm.origin[1])*invH - 0.5f, g, periodic, &y0, &y1, &wy);
+        PmCicWeights((b.position.z - pm.origin[2])*invH - 0.5f, g, periodic, &z0, &z1, &wz);
+        int xs[2] = { x0, x1 }, ys[2] = { y0, y1 }, zs[2] = { z0, z1 };
+        float wxs[2] = { 1.0f - wx, wx }, wys[2] = { 1.0f - wy, wy }, wzs[2] = { 1.0f - wz, wz };
+        for (int c = 0; c < 8; c++) {
+            float w = b.mass*wxs[c & 1]*wys[(c >> 1) & 1]*wzs[c >> 2];
+            pm.mesh[((size_t)zs[c >> 2]*n + ys[(c >> 1) & 1])*n + xs[c & 1]] += w;
+        }
+    }
+
+    // Потенциал без множителя G: phi = -sum m/r (изолированные), del^2 phi = 4 pi rho (периодические)
+    PmFft3D(pm, pm.mesh, false, (size_t)g, pool);
+    float scale = -1.0f/(h*(float)(n*n*n));
+    for (size_t i = 0; i < pm.mesh.size(); i++) pm.mesh[i] = PmMul(pm.mesh[i], pm.green[i])*scale;
+    PmFft3D(pm, pm.mesh, true, (size_t)g, pool);
+
+    // Ускорение на сетке: a = -grad(phi)
+    size_t cells = (size_t)g*g*g;
+    pm.ax.resize(cells); pm.ay.resize(cells); pm.az.resize(cells);
+    auto phi = [&](int i, int j, int k) -> float {
+        if (periodic) { i = (i + g) % g; j = (j + g) % g; k = (k + g) % g; }
+        else {
+            i = (i < 0) ? 0 : (i >= g ? g - 1 : i);
+            j = (j < 0) ? 0 : (j >= g ? g - 1 : j);
+            k = (k < 0) ? 0 : (k >= g ? g - 1 : k);
+        }
+        return pm.mesh[((size_t)k*n + j)*n + i].real();
+    };
+    float invTwoH = 0.5f*invH;
+    ParallelFor(pool, (size_t)g, 1, [&](size_t begin, size_t end) {
+        for (int k = (int)begin; k < (int)end; k++) {
+            for (int j = 0; j < g; j++) {
+                for (int i = 0; i < g; i++) {
+                    size_t c = ((size_t)k*g + j)*g + i;
+                    pm.ax[c] = -(phi(i + 1, j, k) - phi(i - 1, j, k))*invTwoH;
+                    pm.ay[c] = -(phi(i, j + 1, k) - phi(i, j - 1, k))*invTwoH;
+                    pm.az[c] = -(phi(i, j, k + 1) - phi(i, j, k - 1))*invTwoH;
+                }
+            }
+        }
+    });
+
+    // Обратная интерполяция теми же весами CIC
+    ParallelFor(pool, bodies.size(), 256, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; b++) {
+            if (bodies[b].isFixed) continue;
+            const Vector3& p = bodies[b].position;
+            int x0, x1, y0, y1, z0, z1;
+            float wx, wy, wz;
+            PmCicWeights((p.x - pm.origin[0])*invH - 0.5f, g, periodic, &x0, &x1, &wx);
+            PmCicWeights((p.y - pm.origin[1])*invH - 0.5f, g, periodic, &y0, &y1, &wy);
+            PmCicWeights((p.z - pm.origin[2])*invH - 0.5f, g, periodic, &z0, &z1, &wz);
+            int xs[2] = { x0, x1 }, ys[2] = { y0, y1 }, zs[2] = { z0, z1 };
+            float wxs[2] = { 1.0f - wx, wx }, wys[2] = { 1.0f - wy, wy }, wzs[2] = { 1.0f - wz, wz };
+            float sx = 0.0f, sy = 0.0f, sz = 0.0f;
+            for (int c = 0; c < 8; c++) {
+                float w = wxs[c & 1]*wys[(c >> 1) & 1]*wzs[c >> 2];
+                size_t cell = ((size_t)zs[c >> 2]*g + ys[(c >> 1) & 1])*g + xs[c & 1];
+                sx += w*pm.ax[cell]; sy += w*pm.ay[cell]; sz += w*pm.az[cell];
+            }
+            acc[b] = { G*sx, G*sy, G*sz };
+        }
+    });
+}
+
+#endif
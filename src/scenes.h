@@ -0,0 +1,141 @@
+#ifndef SCENES_H
+#define SCENES_H
+
+#include "gravity.h"
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstring>
+
+// --- СЦЕНЫ ---
+enum SceneId {
+    SCENE_DEFAULT = 0,  // звезда и одна планета
+    SCENE_DISK,         // звезда и диск из лёгких тел на круговых орбитах
+    SCENE_CLOUD,        // однородное пылевое облако без звезды
+    SCENE_MOONS,        // диск и несколько планет с тесными спутниками
+    SCENE_COUNT
+};
+
+inline const char* SceneName(SceneId scene) {
+    switch (scene) {
+        case SCENE_DEFAULT: return "default";
+        case SCENE_DISK: return "disk";
+        case SCENE_CLOUD: return "cloud";
+        case SCENE_MOONS: return "moons";
+        default: return "?";
+    }
+}
+
+// Решатель, которым сцену стоит считать, если он не задан явно
+inline GravitySolver SceneSolver(SceneId scene) {
+    switch (scene) {
+        case SCENE_CLOUD: return SOLVER_PM;
+        default: return SOLVER_DIRECT;
+    }
+}
+
+// Схема по умолчанию: тесным парам нужен свой мелкий шаг, остальным — нет
+inline Integrator SceneIntegrator(SceneId scene) {
+    switch (scene) {
+        case SCENE_MOONS: return INTEGRATOR_HERMITE;
+        default: return INTEGRATOR_LEAPFROG;
+    }
+}
+
+inline bool ParseSceneName(const char* name, SceneId* scene) {
+    for (int s = 0; s < SCENE_COUNT; s++) {
+        if (strcmp(name, SceneName((SceneId)s)) == 0) { *scene = (SceneId)s; return true; }
+    }
+    return false;
+}
+
+inline void AddDiskBodies(std::vector<Body>& bodies, int count, float starMass, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (int k = 0; k < count; k++) {
+        float r = 30.0f + 170.0f*sqrtf(unit(rng));
+        float angle = 2.0f*PI*unit(rng);
+        float height = (unit(rng) - 0.5f)*2.0f;
+        float speed = sqrtf(G*starMass/r);
+        float mass = 1.0f + 4.0f*unit(rng);
+        bodies.push_back({
+            { r*cosf(angle), height, r*sinf(angle) },
+            { -speed*sinf(angle), 0.0f, speed*cosf(angle) },
+            mass,
+            1.0f,
+            (mass > 4.0f) ? SKYBLUE : WHITE,
+            false
+        });
+    }
+}
+
+// Однородный шар со слабым вращением и случайными скоростями ниже вириальных
+inline void AddCloudBodies(std::vector<Body>& bodies, int count, float cloudRadius, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_real_distribution<float> sym(-1.0f, 1.0f);
+    float totalMass = 3.0f*count;
+    float speed = 0.3f*sqrtf(G*totalMass/cloudRadius);
+    for (int k = 0; k < count; k++) {
+        Vector3 p;
+        do { p = { sym(rng), sym(rng), sym(rng) }; } while (Vector3LengthSqr(p) > 1.0f);
+        p = Vector3Scale(p, cloudRadius);
+        Vector3 spin = Vector3Scale({ -p.z, 0.0f, p.x }, 0.5f*speed/cloudRadius);
+        Vector3 jitter = Vector3Scale({ sym(rng), sym(rng), sym(rng) }, speed);
+        float mass = 1.0f + 4.0f*unit(rng);
+        bodies.push_back({ p, Vector3Add(spin, jitter), mass, 1.0f, (mass > 4.0f) ? BEIGE : GRAY, false });
+    }
+}
+
+// Планеты на круговых орбитах, у каждой спутник на расстоянии в пару радиусов:
+// период пары в сотни раз короче периода диска
+inline void AddMoonPairs(std::vector<Body>& bodies, int count, float starMass, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const float planetMass = 50.0f;
+    const float moonMass = 0.5f;
+    const float separation = 0.6f;
+    for (int k = 0; k < count; k++) {
+        float r = 230.0f + 100.0f*(k + unit(rng))/count;  // снаружи диска: пыль не падает на пары
+        float angle = 2.0f*PI*unit(rng);
+        float speed = sqrtf(G*starMass/r);
+        Vector3 p = { r*cosf(angle), 0.0f, r*sinf(angle) };
+        Vector3 v = { -speed*sinf(angle), 0.0f, speed*cosf(angle) };
+        // Спутник в плоскости орбиты, скорость относительно планеты — круговая
+        Vector3 dir = Vector3Normalize(p);
+        Vector3 tangent = { -dir.z, 0.0f, dir.x };
+        float moonSpeed = sqrtf(G*(planetMass + moonMass)/separation);
+        float share = moonMass/(planetMass + moonMass);
+        bodies.push_back({
+            Vector3Subtract(p, Vector3Scale(dir, separation*share)),
+            Vector3Subtract(v, Vector3Scale(tangent, moonSpeed*share)),
+            planetMass, 0.3f, SKYBLUE, false
+        });
+        bodies.push_back({
+            Vector3Add(p, Vector3Scale(dir, separation*(1.0f - share))),
+            Vector3Add(v, Vector3Scale(tangent, moonSpeed*(1.0f - share))),
+            moonMass, 0.1f, LIGHTGRAY, false
+        });
+    }
+}
+
+inline void LoadScene(std::vector<Body>& bodies, SceneId scene, int bodyCount) {
+    bodies.clear();
+    if (scene == SCENE_CLOUD) {
+        AddCloudBodies(bodies, bodyCount, 150.0f, 1234u);
+        return;
+    }
+    bodies.push_back({ {0,0,0}, {0,0,0}, 5000.0f, 10.0f, GOLD, true });
+    switch (scene) {
+        case SCENE_DISK: AddDiskBodies(bodies, bodyCount, 5000.0f, 1234u); break;
+        case SCENE_MOONS:
+            // Диск из пыли: лёгкие тела не сближаются друг с другом круче пар
+            AddDiskBodies(bodies, bodyCount, 5000.0f, 1234u);
+            for (size_t i = 1; i < bodies.size(); i++) bodies[i].mass *= 0.001f;
+            AddMoonPairs(bodies, 6, 5000.0f, 4321u);
+            break;
+        default: bodies.push_back({ {50,0,0}, {0,0,310.0f}, 100.0f, 3.0f, SKYBLUE, false }); break;
+    }
+}
+
+#endif
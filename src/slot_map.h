@@ -0,0 +1,198 @@
+#ifndef SLOT_MAP_H
+#define SLOT_MAP_H
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+// --- SLOT MAP ---
+// Элементы лежат плотно в dense (ядра физики идут по нему как по обычному
+// вектору), а снаружи на них ссылаются ручками: слот + поколение. Слот
+// хранит текущий индекс элемента в dense; при удалении последний элемент
+// переезжает на место удалённого, слот переезжающего исправляется, слот
+// удалённого уходит в список свободных с новым поколением. Старая ручка
+// после этого ничего не находит, даже когда слот займёт другой элемент.
+// Поколения берутся из общего счётчика, который откат (RestoreSlots) не
+// трогает: одно поколение не выдаётся дважды ни в одной ветке.
+// Вставка и удаление — O(1), порядок dense при удалении не сохраняется.
+
+const uint32_t SLOT_NONE = 0xffffffffu;
+
+struct SlotHandle {
+    uint32_t slot;
+    uint32_t generation;  // 0 — пустая ручка (поколения живых слотов с 1)
+    bool operator==(const SlotHandle& o) const { return slot == o.slot && generation == o.generation; }
+    bool operator!=(const SlotHandle& o) const { return !(*this == o); }
+};
+
+const SlotHandle NO_SLOT = { SLOT_NONE, 0 };
+
+struct SlotEntry {
+    uint32_t index;       // индекс в dense; у свободного — следующий свободный слот
+    uint32_t generation;
+};
+
+template <typename T>
+struct SlotMap {
+    std::vector<T> dense;
+    std::vector<uint32_t> owners;  // слот каждого элемента dense
+    std::vector<SlotEntry> slots;
+    uint32_t freeSlot = SLOT_NONE; // голова списка свободных
+    uint32_t nextGeneration = 1;   // следующее свежее поколение
+};
+
+template <typename T>
+inline uint32_t FreshGeneration(SlotMap<T>& map) {
+    uint32_t generation = map.nextGeneration++;
+    if (map.nextGeneration == 0) map.nextGeneration = 1;
+    return generation;
+}
+
+template <typename T>
+inline SlotHandle InsertSlot(SlotMap<T>& map, const T& value) {
+    uint32_t slot = map.freeSlot;
+    if (slot != SLOT_NONE) {
+        map.freeSlot = map.slots[slot].index;
+    } else {
+        slot = (uint32_t)map.slots.size();
+        map.slots.push_back({ 0, FreshGeneration(map) });
+    }
+    map.slots[slot].index = (uint32_t)map.dense.size();
+    map.dense.push_back(value);
+    map.owners.push_back(slot);
+    return { slot, map.slots[slot].generation };
+}
+
+// Индекс в dense или -1, если ручка пустая или элемент уже удалён.
+// Поколения одного мало: свободный слот уже несёт поколение будущего
+// жильца, а index у него — звено списка свободных. Ручку, выданную в
+// отброшенном будущем (перемотка назад), отсекает проверка владельца.
+template <typename T>
+inline int SlotIndex(const SlotMap<T>& map, SlotHandle handle) {
+    if (handle.slot >= map.slots.size()) return -1;
+    const SlotEntry& entry = map.slots[handle.slot];
+    if (entry.generation != handle.generation || entry.index >= map.dense.size()) return -1;
+    return (map.owners[entry.index] == handle.slot) ? (int)entry.index : -1;
+}
+
+template <typename T>
+inline T* SlotGet(SlotMap<T>& map, SlotHandle handle) {
+    int index = SlotIndex(map, handle);
+    return (index >= 0) ? &map.dense[index] : nullptr;
+}
+
+// Ручка элемента dense[index]
+template <typename T>
+inline SlotHandle SlotAt(const SlotMap<T>& map, size_t index) {
+    uint32_t slot = map.owners[index];
+    return { slot, map.slots[slot].generation };
+}
+
+// Слот освобождается: новое поколение гасит все старые ручки
+template <typename T>
+inline void RetireSlot(SlotMap<T>& map, uint32_t slot) {
+    SlotEntry& entry = map.slots[slot];
+    entry.generation = FreshGeneration(map);
+    entry.index = map.freeSlot;
+    map.freeSlot = slot;
+}
+
+// Удаление обменом с последним: false — ручка уже ничего не значит
+template <typename T>
+inline bool RemoveSlot(SlotMap<T>& map, SlotHandle handle) {
+    int index = SlotIndex(map, handle);
+    if (index < 0) return false;
+    uint32_t last = (uint32_t)map.dense.size() - 1;
+    if ((uint32_t)index != last) {
+        map.dense[index] = map.dense[last];
+        map.owners[index] = map.owners[last];
+        map.slots[map.owners[index]].index = (uint32_t)index;
+    }
+    map.dense.pop_back();
+    map.owners.pop_back();
+    RetireSlot(map, handle.slot);
+    return true;
+}
+
+// Пачка удалений по индексам dense: от больших к меньшим, каждое — обмен с
+// последним, так что на место удалённого никогда не приходит другой
+// обречённый. from[k] — прежний индекс элемента, стоящего теперь на k
+// (по нему переставляют параллельные массивы). indices сортируются.
+template <typename T>
+inline void RemoveSlotsAt(SlotMap<T>& map, std::vector<int>& indices, std::vector<int>& from) {
+    std::sort(indices.begin(), indices.end(), [](int a, int b) { return a > b; });
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    from.resize(map.dense.size());
+    for (size_t k = 0; k < from.size(); k++) from[k] = (int)k;
+    for (int index : indices) {
+        uint32_t slot = map.owners[index];
+        size_t last = map.dense.size() - 1;
+        if ((size_t)index != last) {
+            map.dense[index] = map.dense[last];
+            map.owners[index] = map.owners[last];
+            map.slots[map.owners[index]].index = (uint32_t)index;
+            from[index] = from[last];
+        }
+        map.dense.pop_back();
+        map.owners.pop_back();
+        from.pop_back();
+        RetireSlot(map, slot);
+    }
+}
+
+// dense уже сжат на месте с сохранением порядка: dense[k] — бывший
+// dense[survivors[k]], survivors возрастают (так сливает тела collisions.h).
+// Слоты выживших следуют за ними, слоты остальных освобождаются.
+template <typename T>
+inline void RetainSlots(SlotMap<T>& map, const std::vector<int>& survivors) {
+    size_t k = 0;
+    for (size_t i = 0; i < map.owners.size(); i++) {
+        uint32_t slot = map.owners[i];
+        if (k < survivors.size() && survivors[k] == (int)i) {
+            map.owners[k] = slot;  // k <= i: источник уже прочитан
+            map.slots[slot].index = (uint32_t)k;
+            k++;
+        } else {
+            RetireSlot(map, slot);
+        }
+    }
+    map.owners.resize(k);
+}
+
+// Откат к сохранённому состоянию (ключевой кадр): элементы и живые слоты
+// из saved, счётчик поколений — свой. Свободные слоты получают свежие
+// поколения, слоты, заведённые после сохранения, остаются свободными:
+// ручка из отброшенного будущего не найдёт элемент новой ветки.
+template <typename T>
+inline void RestoreSlots(SlotMap<T>& map, const SlotMap<T>& saved) {
+    size_t slotCount = std::max(map.slots.size(), saved.slots.size());
+    uint32_t nextGeneration = map.nextGeneration;
+    map.dense = saved.dense;
+    map.owners = saved.owners;
+    map.slots = saved.slots;
+    map.nextGeneration = nextGeneration;
+    map.slots.resize(slotCount);
+    std::vector<unsigned char> live(slotCount, 0);
+    for (uint32_t slot : map.owners) live[slot] = 1;
+    map.freeSlot = SLOT_NONE;
+    for (size_t slot = slotCount; slot-- > 0;) {
+        if (!live[slot]) RetireSlot(map, (uint32_t)slot);
+    }
+}
+
+template <typename T>
+inline void ClearSlots(SlotMap<T>& map) {
+    for (uint32_t slot : map.owners) RetireSlot(map, slot);
+    map.dense.clear();
+    map.owners.clear();
+}
+
+// Все элементы заново, у каждого новая ручка
+template <typename T>
+inline void AssignSlots(SlotMap<T>& map, const std::vector<T>& values) {
+    ClearSlots(map);
+    for (const T& value : values) InsertSlot(map, value);
+}
+
+#endif
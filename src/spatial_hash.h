@@ -0,0 +1,78 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include "gravity.h"
+#include <vector>
+#include <cmath>
+#include <cstdint>
+
+// --- ПРОСТРАНСТВЕННЫЙ ХЕШ ---
+// Равномерная сетка без границ: ячейка (x, y, z) хешируется в одну из
+// степени двойки корзин, тела корзины связаны списком. Строится заново за
+// O(N) на каждый шаг. Разные ячейки могут попасть в одну корзину —
+// соседей всё равно отсеивает расстояние. Тела, которые в ячейку не
+// помещаются (или не нужны в сетке), кладутся в отдельный список large
+// и проверяются перебором — их обычно единицы.
+
+struct SpatialHash {
+    std::vector<int> head;   // первое тело корзины или -1
+    std::vector<int> next;   // следующее тело той же корзины
+    std::vector<int> large;  // вне сетки
+    uint32_t mask = 0;       // корзин — степень двойки минус один
+    float cell = 1.0f;
+};
+
+inline uint32_t SpatialHashBucket(const SpatialHash& hash, int x, int y, int z) {
+    uint32_t h = (uint32_t)x*73856093u ^ (uint32_t)y*19349663u ^ (uint32_t)z*83492791u;
+    return h & hash.mask;
+}
+
+// outside(i) — тело i идёт в large, а не в сетку
+template <typename Outside>
+inline void BuildSpatialHash(SpatialHash& hash, const std::vector<Body>& bodies, float cell, Outside outside) {
+    uint32_t buckets = 64;
+    while (buckets < 2*bodies.size()) buckets *= 2;
+    hash.mask = buckets - 1;
+    hash.cell = cell;
+    hash.head.assign(buckets, -1);
+    hash.next.resize(bodies.size());
+    hash.large.clear();
+    for (size_t i = 0; i < bodies.size(); i++) {
+        if (outside((int)i)) {
+            hash.large.push_back((int)i);
+            continue;
+        }
+        Vector3 p = bodies[i].position;
+        uint32_t bucket = SpatialHashBucket(hash, (int)floorf(p.x/cell), (int)floorf(p.y/cell), (int)floorf(p.z/cell));
+        hash.next[i] = hash.head[bucket];
+        hash.head[bucket] = (int)i;
+    }
+}
+
+// Обходит тела сетки в ячейках на span вокруг ячейки p (span = 1 — 27 ячеек)
+template <typename Fn>
+inline void ForEachInSpatialHash(const SpatialHash& hash, Vector3 p, int span, Fn fn) {
+    int cx = (int)floorf(p.x/hash.cell), cy = (int)floorf(p.y/hash.cell), cz = (int)floorf(p.z/hash.cell);
+    for (int dx = -span; dx <= span; dx++)
+        for (int dy = -span; dy <= span; dy++)
+            for (int dz = -span; dz <= span; dz++) {
+                for (int j = hash.head[SpatialHashBucket(hash, cx + dx, cy + dy, cz + dz)]; j >= 0; j = hash.next[j]) fn(j);
+            }
+}
+
+// Обходит тела сетки в ячейках, которые задевает куб [p - radius, p + radius]:
+// по оси их floor((p + radius)/cell) - floor((p - radius)/cell) + 1, при
+// radius <= cell/2 — не больше двух
+template <typename Fn>
+inline void ForEachNearInSpatialHash(const SpatialHash& hash, Vector3 p, float radius, Fn fn) {
+    int x0 = (int)floorf((p.x - radius)/hash.cell), x1 = (int)floorf((p.x + radius)/hash.cell);
+    int y0 = (int)floorf((p.y - radius)/hash.cell), y1 = (int)floorf((p.y + radius)/hash.cell);
+    int z0 = (int)floorf((p.z - radius)/hash.cell), z1 = (int)floorf((p.z + radius)/hash.cell);
+    for (int x = x0; x <= x1; x++)
+        for (int y = y0; y <= y1; y++)
+            for (int z = z0; z <= z1; z++) {
+                for (int j = hash.head[SpatialHashBucket(hash, x, y, z)]; j >= 0; j = hash.next[j]) fn(j);
+            }
+}
+
+#endif
@@ -0,0 +1,184 @@
+#ifndef SWEEP_AND_PRUNE_H
+#define SWEEP_AND_PRUNE_H
+
+#include "gravity.h"
+#include <vector>
+#include <algorithm>
+#include <unordered_set>
+#include <cstdint>
+
+// --- SWEEP AND PRUNE ---
+// Постоянный broadphase: концы проекций AABB тел на каждую ось лежат в
+// отсортированных массивах и переживают шаг. За шаг тела сдвигаются мало,
+// массивы почти упорядочены, и сортировка вставками чинит их за
+// O(N + число перестановок). Перестановка — событие: начало отрезка ушло
+// левее конца другого — пара, возможно, начала пересекаться (проверяем
+// коробки целиком), конец ушёл левее начала — пара разошлась. Множество
+// пересекающихся пар меняется только по этим событиям.
+// Тело — индекс в векторе тел. Дописанные в конец (новое тело строителя,
+// звезда после сброса) встают в массивы сами при следующем обновлении;
+// слияния переносит RemapSweepAndPrune; если тел стало меньше без него
+// или состояние подменили целиком (InvalidateSweepAndPrune) — пересборка.
+// Коробка тела накрывает сферу в начале шага from[i] и в конце: для тела,
+// проскочившего за шаг больше радиуса, — весь путь (collisions.h).
+
+struct SapEndpoint {
+    float value;
+    uint32_t tag;  // тело << 1, младший бит — начало отрезка
+};
+
+struct SweepAndPrune {
+    std::vector<SapEndpoint> axes[3];
+    std::vector<float> boxes;            // на тело: min x, y, z, max x, y, z
+    std::unordered_set<uint64_t> pairs;  // меньший индекс << 32 | больший
+    std::vector<int> remap;
+    size_t count = 0;                    // тел в массивах
+    bool valid = false;
+    long long swaps = 0;                 // перестановок при последнем обновлении
+};
+
+inline uint64_t SapPairKey(uint32_t a, uint32_t b) {
+    return (a < b) ? ((uint64_t)a << 32 | b) : ((uint64_t)b << 32 | a);
+}
+
+// При равных значениях конец раньше начала: касание коробок — не пересечение
+inline bool SapBefore(const SapEndpoint& a, const SapEndpoint& b) {
+    return a.value < b.value || (a.value == b.value && (a.tag & 1) < (b.tag & 1));
+}
+
+inline bool SapBoxesOverlap(const SweepAndPrune& sap, uint32_t a, uint32_t b) {
+    const float* p = &sap.boxes[6*a];
+    const float* q = &sap.boxes[6*b];
+    return p[0] < q[3] && q[0] < p[3] && p[1] < q[4] && q[1] < p[4] && p[2] < q[5] && q[2] < p[5];
+}
+
+inline void FillSapBoxes(SweepAndPrune& sap, const std::vector<Body>& bodies, const std::vector<Vector3>& from) {
+    sap.boxes.resize(6*bodies.size());
+    for (size_t i = 0; i < bodies.size(); i++) {
+        const Body& b = bodies[i];
+        Vector3 lo = Vector3Min(from[i], b.position), hi = Vector3Max(from[i], b.position);
+        float* box = &sap.boxes[6*i];
+        box[0] = lo.x - b.radius; box[3] = hi.x + b.radius;
+        box[1] = lo.y - b.radius; box[4] = hi.y + b.radius;
+        box[2] = lo.z - b.radius; box[5] = hi.z + b.radius;
+    }
+}
+
+// Полная сборка: сортировка и проход по оси x со списком открытых отрезков
+inline void RebuildSweepAndPrune(SweepAndPrune& sap, const std::vector<Body>& bodies, const std::vector<Vector3>& from) {
+    size_t n = bodies.size();
+    FillSapBoxes(sap, bodies, from);
+    for (int axis = 0; axis < 3; axis++) {
+        std::vector<SapEndpoint>& e = sap.axes[axis];
+        e.resize(2*n);
+        for (size_t i = 0; i < n; i++) {
+            e[2*i] = { sap.boxes[6*i + axis], (uint32_t)i << 1 | 1 };
+            e[2*i + 1] = { sap.boxes[6*i + 3 + axis], (uint32_t)i << 1 };
+        }
+        std::sort(e.begin(), e.end(), SapBefore);
+    }
+    sap.pairs.clear();
+    std::vector<int> open, slot(n, -1);  // открытые отрезки и место тела в open
+    for (const SapEndpoint& end : sap.axes[0]) {
+        uint32_t i = end.tag >> 1;
+        if (end.tag & 1) {
+            for (int j : open) if (SapBoxesOverlap(sap, i, (uint32_t)j)) sap.pairs.insert(SapPairKey(i, (uint32_t)j));
+            slot[i] = (int)open.size();
+            open.push_back((int)i);
+        } else if (slot[i] >= 0) {
+            int last = open.back();
+            open[slot[i]] = last;
+            slot[last] = slot[i];
+            open.pop_back();
+            slot[i] = -1;
+        }
+    }
+    sap.count = n;
+    sap.valid = true;
+    sap.swaps = 0;
+}
+
+// Сортировка вставками одной оси с событиями пар
+inline void SortSapAxis(SweepAndPrune& sap, int axis) {
+    std::vector<SapEndpoint>& e = sap.axes[axis];
+    for (size_t k = 0; k < e.size(); k++) {
+        SapEndpoint& end = e[k];
+        uint32_t i = end.tag >> 1;
+        end.value = sap.boxes[6*i + ((end.tag & 1) ? 0 : 3) + axis];
+    }
+    for (size_t k = 1; k < e.size(); k++) {
+        SapEndpoint cur = e[k];
+        size_t m = k;
+        uint32_t a = cur.tag >> 1;
+        while (m > 0 && SapBefore(cur, e[m - 1])) {
+            const SapEndpoint& prev = e[m - 1];
+            uint32_t b = prev.tag >> 1;
+            if (a != b) {
+                bool curStart = cur.tag & 1, prevStart = prev.tag & 1;
+                if (curStart && !prevStart) {
+                    if (SapBoxesOverlap(sap, a, b)) sap.pairs.insert(SapPairKey(a, b));
+                } else if (!curStart && prevStart) {
+                    sap.pairs.erase(SapPairKey(a, b));
+                }
+            }
+            e[m] = prev;
+            m--;
+            sap.swaps++;
+        }
+        e[m] = cur;
+    }
+}
+
+// Раз за шаг: коробки по текущим телам, массивы и пары в порядок
+inline void UpdateSweepAndPrune(SweepAndPrune& sap, const std::vector<Body>& bodies, const std::vector<Vector3>& from) {
+    size_t n = bodies.size();
+    if (!sap.valid || n < sap.count) {
+        RebuildSweepAndPrune(sap, bodies, from);
+        return;
+    }
+    FillSapBoxes(sap, bodies, from);
+    // Новые тела — в конец массивов: сортировка вставками проведёт их на
+    // место, и каждое пересечение по пути станет событием
+    for (size_t i = sap.count; i < n; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            sap.axes[axis].push_back({ 0.0f, (uint32_t)i << 1 | 1 });
+            sap.axes[axis].push_back({ 0.0f, (uint32_t)i << 1 });
+        }
+    }
+    sap.count = n;
+    sap.swaps = 0;
+    for (int axis = 0; axis < 3; axis++) SortSapAxis(sap, axis);
+}
+
+// После слияний или уборки: survivors[новый] = старый. Порядок выживших
+// не важен: концы остаются отсортированными по значениям, меняются имена.
+inline void RemapSweepAndPrune(SweepAndPrune& sap, const std::vector<int>& survivors) {
+    if (!sap.valid) return;
+    sap.remap.assign(sap.count, -1);
+    for (size_t k = 0; k < survivors.size(); k++) sap.remap[survivors[k]] = (int)k;
+    for (int axis = 0; axis < 3; axis++) {
+        std::vector<SapEndpoint>& e = sap.axes[axis];
+        size_t kept = 0;
+        for (const SapEndpoint& end : e) {
+            int to = sap.remap[end.tag >> 1];
+            if (to >= 0) e[kept++] = { end.value, (uint32_t)to << 1 | (end.tag & 1) };
+        }
+        e.resize(kept);
+    }
+    std::unordered_set<uint64_t> pairs;
+    pairs.reserve(sap.pairs.size());
+    for (uint64_t key : sap.pairs) {
+        int a = sap.remap[key >> 32], b = sap.remap[key & 0xffffffffu];
+        if (a >= 0 && b >= 0) pairs.insert(SapPairKey((uint32_t)a, (uint32_t)b));
+    }
+    sap.pairs.swap(pairs);
+    sap.count = survivors.size();
+}
+
+// Тела подменены целиком (сброс, ключевой кадр): дешевле собрать заново,
+// чем сортировать вставками скачок через всю сцену
+inline void InvalidateSweepAndPrune(SweepAndPrune& sap) {
+    sap.valid = false;
+}
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "raylib.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+#if defined(__linux__)
+    #include <sched.h>
+#endif
+
+// --- ПУЛ ПОТОКОВ ---
+// Постоянные рабочие потоки для параллельных циклов физики.
+// ParallelFor раздаёт диапазон кусками; вызывающий поток тоже работает.
+// Куски пишут в непересекающиеся элементы, поэтому результат не зависит
+// ни от числа потоков, ни от того, какой поток взял какой кусок.
+
+struct ThreadPool {
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable startCv;
+    std::condition_variable doneCv;
+    const std::function<void(size_t, size_t)>* job = nullptr;
+    size_t jobCount = 0;
+    size_t jobChunk = 1;
+    std::atomic<size_t> nextIndex{0};
+    unsigned int generation = 0;
+    int busyWorkers = 0;
+    bool quit = false;
+};
+
+// Привязывает текущий поток к ядру; false, если платформа не умеет
+inline bool PinCurrentThread(int cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+inline void RunPoolJob(ThreadPool& pool) {
+    for (;;) {
+        size_t begin = pool.nextIndex.fetch_add(pool.jobChunk);
+        if (begin >= pool.jobCount) break;
+        size_t end = (begin + pool.jobChunk < pool.jobCount) ? begin + pool.jobChunk : pool.jobCount;
+        (*pool.job)(begin, end);
+    }
+}
+
+inline void PoolWorkerLoop(ThreadPool* pool, int cpu) {
+    if (cpu >= 0 && !PinCurrentThread(cpu)) TraceLog(LOG_WARNING, "THREADS: Failed to pin worker to CPU %d", cpu);
+
+    unsigned int seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            pool->startCv.wait(lock, [&]() { return pool->quit || pool->generation != seen; });
+            if (pool->quit) return;
+            seen = pool->generation;
+        }
+        RunPoolJob(*pool);
+        {
+            std::lock_guard<std::mutex> lock(pool->mutex);
+            pool->busyWorkers--;
+        }
+        pool->doneCv.notify_one();
+    }
+}
+
+// threadCount — всего потоков вместе с вызывающим (0 = по числу ядер).
+// cpus — ядра для рабочих потоков по кругу; пустой список = без привязки.
+inline void StartThreadPool(ThreadPool& pool, int threadCount, const std::vector<int>& cpus) {
+#if defined(PLATFORM_WEB)
+    threadCount = 1;
+#endif
+    if (threadCount <= 0) threadCount = (int)std::thread::hardware_concurrency();
+    if (threadCount <= 0) threadCount = 1;
+
+    pool.quit = false;
+    for (int w = 0; w < threadCount - 1; w++) {
+        int cpu = cpus.empty() ? -1 : cpus[w % cpus.size()];
+        pool.workers.emplace_back(PoolWorkerLoop, &pool, cpu);
+    }
+    TraceLog(LOG_INFO, "THREADS: Physics pool started with %d threads", threadCount);
+}
+
+inline void StopThreadPool(ThreadPool& pool) {
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.quit = true;
+    }
+    pool.startCv.notify_all();
+    for (auto& t : pool.workers) t.join();
+    pool.workers.clear();
+}
+
+inline int ThreadPoolSize(const ThreadPool* pool) {
+    return (pool != nullptr) ? (int)pool->workers.size() + 1 : 1;
+}
+
+// fn(begin, end) вызывается для кусков [0, count) размером chunk
+inline void ParallelFor(ThreadPool* pool, size_t count, size_t chunk, const std::function<void(size_t, size_t)>& fn) {
+    if (count == 0) return;
+    if (chunk == 0) chunk = 1;
+    if (pool == nullptr || pool->workers.empty() || count <= chunk) {
+        fn(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->job = &fn;
+        pool->jobCount = count;
+        pool->jobChunk = chunk;
+        pool->nextIndex.store(0);
+        pool->busyWorkers = (int)pool->workers.size();
+        pool->generation++;
+    }
+    pool->startCv.notify_all();
+
+    RunPoolJob(*pool);
+
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    pool->doneCv.wait(lock, [&]() { return pool->busyWorkers == 0; });
+    pool->job = nullptr;
+}
+
+#endif
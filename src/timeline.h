@@ -0,0 +1,116 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include "gravity.h"
+#include "floating_origin.h"
+#include "slot_map.h"
+#include <vector>
+#include <algorithm>
+
+// --- ЛИНИЯ ВРЕМЕНИ ---
+// Ключевые кадры — полные состояния тел через каждые KEYFRAME_INTERVAL шагов
+// в кольце фиксированного объёма: старые вытесняются, память от длины
+// прогона не зависит. Перемотка восстанавливает ближайший кадр не позже
+// цели и досчитывает до неё теми же шагами, так что стоит не больше одного
+// интервала.
+// Досчёт совпадает с исходным прогоном бит в бит, потому что ключевой кадр —
+// точка перезапуска: и при записи, и при восстановлении кэши схем (ускорения
+// leapfrog, double-состояние Эрмита и Wisdom-Holman, пары) сбрасываются и
+// строятся заново из тех же тел. События, которые не повторить шагами
+// (новое тело, сброс, смена настроек или шага, перенос начала координат),
+// обрезают будущее и сразу пишут кадр — между соседними кадрами идут
+// только шаги с одним dt.
+
+const int KEYFRAME_INTERVAL = 240;        // шагов между кадрами: потолок цены перемотки
+const int TIMELINE_MAX_KEYFRAMES = 128;
+const size_t TIMELINE_MEMORY = (size_t)64 << 20;  // байт на тела всех кадров
+
+struct Keyframe {
+    long long step;      // номер шага симуляции
+    double time;         // время симуляции
+    float dt;            // шаг до следующего кадра
+    WorldOrigin origin;
+    GravitySettings gravity;
+    float timeSpeed;     // из чего сложился dt (см. PhysicsStepDt)
+    int substeps;
+    float timeScale;
+    double whStep;
+    SlotMap<Body> bodies;  // с ручками: после перемотки камера следит за тем же телом
+};
+
+struct Timeline {
+    std::vector<Keyframe> slots;
+    int first = 0;       // слот самого старого кадра
+    int count = 0;
+    long long horizonStep = 0;  // дальше этого шага на текущей ветке не считали
+    double horizonTime = 0.0;
+};
+
+// Сколько кадров влезает в TIMELINE_MEMORY при bodyCount телах
+inline int TimelineCapacity(size_t bodyCount) {
+    size_t perFrame = std::max<size_t>(1, bodyCount)*sizeof(Body);
+    return (int)std::clamp<size_t>(TIMELINE_MEMORY/perFrame, 2, TIMELINE_MAX_KEYFRAMES);
+}
+
+// k-й кадр от самого старого
+inline Keyframe& TimelineAt(Timeline& tl, int k) {
+    return tl.slots[(tl.first + k) % tl.slots.size()];
+}
+
+inline const Keyframe& TimelineAt(const Timeline& tl, int k) {
+    return tl.slots[(tl.first + k) % tl.slots.size()];
+}
+
+// Слот под кадр шага step (не раньше последнего). Кадр того же шага
+// перезаписывается; при нехватке места вытесняются самые старые.
+inline Keyframe& PushKeyframe(Timeline& tl, long long step, size_t bodyCount) {
+    if (tl.count > 0 && TimelineAt(tl, tl.count - 1).step == step) return TimelineAt(tl, tl.count - 1);
+    int capacity = TimelineCapacity(bodyCount);
+    if ((int)tl.slots.size() != TIMELINE_MAX_KEYFRAMES) tl.slots.resize(TIMELINE_MAX_KEYFRAMES);
+    while (tl.count >= capacity) {
+        // Буфер тел вытесненного кадра отдаём: при меньшей ёмкости его слот
+        // может больше не понадобиться
+        TimelineAt(tl, 0).bodies = SlotMap<Body>();
+        tl.first = (tl.first + 1) % tl.slots.size();
+        tl.count--;
+    }
+    tl.count++;
+    return TimelineAt(tl, tl.count - 1);
+}
+
+// Будущее после шага step больше не наступит (новая ветка)
+inline void TruncateTimeline(Timeline& tl, long long step, double time) {
+    while (tl.count > 0 && TimelineAt(tl, tl.count - 1).step > step) tl.count--;
+    tl.horizonStep = step;
+    tl.horizonTime = time;
+}
+
+// Последний кадр не позже time (самый старый, если цель раньше всех); -1 — кадров нет
+inline int FindKeyframe(const Timeline& tl, double time) {
+    int lo = 0, hi = tl.count;
+    while (lo < hi) {
+        int mid = (lo + hi)/2;
+        if (TimelineAt(tl, mid).time <= time) lo = mid + 1;
+        else hi = mid;
+    }
+    return (tl.count == 0) ? -1 : std::max(0, lo - 1);
+}
+
+// Кадр ровно на шаге step; -1 — такого нет
+inline int FindKeyframeStep(const Timeline& tl, long long step) {
+    int lo = 0, hi = tl.count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi)/2;
+        long long s = TimelineAt(tl, mid).step;
+        if (s == step) return mid;
+        if (s < step) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return -1;
+}
+
+inline double TimelineStart(const Timeline& tl) {
+    return (tl.count > 0) ? TimelineAt(tl, 0).time : tl.horizonTime;
+}
+
+#endif
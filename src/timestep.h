@@ -0,0 +1,82 @@
+#ifndef TIMESTEP_H
+#define TIMESTEP_H
+
+#include "raylib.h"
+#include "raymath.h"
+#include "gravity.h"
+#include <vector>
+
+// --- ФИКСИРОВАННЫЙ ШАГ ФИЗИКИ ---
+// Реальное время кадра копится в аккумуляторе и расходуется тиками
+// постоянной длины, поэтому скорость симуляции не зависит от FPS.
+// Если физика не успевает, число тиков за кадр ограничено, а
+// непросчитанный хвост выбрасывается: симуляция замедляется, но не
+// проваливается в «спираль смерти», где каждый кадр дольше предыдущего.
+// Отрисовка интерполирует позиции между двумя последними состояниями.
+
+struct FixedTimestep {
+    double tick;         // реальных секунд на один шаг физики
+    double accumulator;  // накопленное, но ещё не просчитанное время
+    int maxSteps;        // потолок шагов за кадр
+    float maxFrameTime;  // дольше этого кадр не учитывается (пауза окна, отладчик)
+    int lastSteps;       // шагов в последнем кадре
+    bool saturated;      // в последнем кадре упёрлись в потолок
+};
+
+inline FixedTimestep MakeFixedTimestep(double tick, int maxSteps) {
+    return { tick, 0.0, maxSteps, 0.25f, 0, false };
+}
+
+// Сколько шагов сделать в этом кадре
+inline int AdvanceTimestep(FixedTimestep& ts, float frameTime) {
+    if (frameTime > ts.maxFrameTime) frameTime = ts.maxFrameTime;
+    if (frameTime < 0.0f) frameTime = 0.0f;
+    ts.accumulator += frameTime;
+    int steps = (int)(ts.accumulator/ts.tick);
+    ts.saturated = steps > ts.maxSteps;
+    if (ts.saturated) {
+        steps = ts.maxSteps;
+        ts.accumulator = 0.0;  // хвост не догоняем
+    } else {
+        ts.accumulator -= steps*ts.tick;
+    }
+    ts.lastSteps = steps;
+    return steps;
+}
+
+// Доля тика, прошедшая после последнего шага: 0 — предыдущее состояние, 1 — текущее
+inline float TimestepAlpha(const FixedTimestep& ts) {
+    float alpha = (float)(ts.accumulator/ts.tick);
+    return (alpha > 1.0f) ? 1.0f : alpha;
+}
+
+// --- ИНТЕРПОЛЯЦИЯ ДЛЯ ОТРИСОВКИ ---
+// Позиции перед последним шагом. Тела, добавленные после снимка,
+// рисуются в текущих позициях.
+
+inline void SavePositions(const std::vector<Body>& bodies, std::vector<Vector3>& previous) {
+    previous.resize(bodies.size());
+    for (size_t i = 0; i < bodies.size(); i++) previous[i] = bodies[i].position;
+}
+
+inline void ShiftPositions(std::vector<Vector3>& positions, Vector3 shift) {
+    for (Vector3& p : positions) p = Vector3Subtract(p, shift);
+}
+
+// Тела убраны или переставлены: from[k] — прежний индекс тела на месте k.
+// Источник всегда не левее цели (from[k] >= k), поэтому на месте.
+inline void RemapPositions(std::vector<Vector3>& positions, const std::vector<int>& from) {
+    for (size_t k = 0; k < from.size(); k++) {
+        if (from[k] < (int)positions.size()) positions[k] = positions[from[k]];
+    }
+    if (positions.size() > from.size()) positions.resize(from.size());
+}
+
+inline void InterpolatePositions(const std::vector<Body>& bodies, const std::vector<Vector3>& previous, float alpha, std::vector<Vector3>& out) {
+    out.resize(bodies.size());
+    for (size_t i = 0; i < bodies.size(); i++) {
+        out[i] = (i < previous.size()) ? Vector3Lerp(previous[i], bodies[i].position, alpha) : bodies[i].position;
+    }
+}
+
+#endif